@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 2 Mar 2024 10:58:11am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "RenderPlayHead.h"
+
+namespace
+{
+    const char* getTargetName(Benchmark::Target target)
+    {
+        return target == Benchmark::Target::riserLine ? "RiserLine" : "Processor";
+    }
+    
+    // eco mode goes in the processor's target name rather than a column of its own, so older baselines still load
+    juce::String getTargetName(Benchmark::Target target, RiseUpAudioProcessor::EcoMode ecoMode)
+    {
+        if (target == Benchmark::Target::riserLine || ecoMode == RiseUpAudioProcessor::EcoMode::off)
+            return getTargetName(target);
+        
+        return juce::String(getTargetName(target)) + (ecoMode == RiseUpAudioProcessor::EcoMode::half ? "/eco-half" : "/eco-quarter");
+    }
+    
+    const char* getStorageName(RiserLineBase::RiserStorage storage)
+    {
+        return storage == RiserLineBase::RiserStorage::int16 ? "int16" : "float32";
+    }
+    
+    const char* getInterpolationName(Interpolation::Quality quality)
+    {
+        switch (quality)
+        {
+            case Interpolation::Quality::hermite:   return "hermite";
+            case Interpolation::Quality::sinc:      return "sinc";
+            case Interpolation::Quality::linear:
+            default:                                return "linear";
+        }
+    }
+    
+    // a case timed with a particular read-head kernel gather has it added, e.g. "linear+avx2"
+    juce::String getInterpolationName(Interpolation::Quality quality, const ReadHeadKernel::NamedGather& gather)
+    {
+        const juce::String name = getInterpolationName(quality);
+        return gather.name != nullptr ? name + "+" + gather.name : name;
+    }
+
+    juce::String getSaturationName(Saturation::Curve curve, bool antialiasing)
+    {
+        const juce::String name = curve == Saturation::Curve::softClip ? "softclip"
+                                : curve == Saturation::Curve::tanh     ? "tanh"
+                                                                       : "hardclip";
+        return antialiasing ? name + "+adaa" : name;
+    }
+
+//    the same noise for every case so runs only differ by the code being timed
+    void fillWithNoise(juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random(4408);
+        
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+    }
+}
+
+Benchmark::Benchmark(const Settings& newSettings) : settings(newSettings)
+{
+}
+
+juce::String Benchmark::getCSVHeader()
+{
+    return "target,sampleRate,blockSize,tempo,delayTime,riserLength,channels,interpolation,riserStorage,saturation,"
+           "nsPerSample,realtimeFactor,footprintBytes,storageErrorDb,vsBaseline";
+}
+
+juce::Array<Benchmark::Case> Benchmark::createCases() const
+{
+    juce::Array<Case> cases;
+    const auto gathers = ReadHeadKernel::getSupportedGathers();
+    
+    for (auto target : settings.targets)
+        for (auto sampleRate : settings.sampleRates)
+            for (auto blockSize : settings.blockSizes)
+                for (auto tempo : settings.tempos)
+                    for (auto delayTime : settings.delayTimes)
+                        for (auto riserLength : settings.riserLengths)
+                            for (auto numChannels : settings.channelCounts)
+                            {
+//                                the read-head kernel only runs for mono RiserLines with linear interpolation, where every
+//                                gather this CPU supports is timed
+                                if (target == Target::riserLine && numChannels == 1 && settings.interpolation == Interpolation::Quality::linear)
+                                {
+                                    for (auto& gather : gathers)
+                                        cases.add({ target, sampleRate, blockSize, tempo, delayTime, riserLength, numChannels, gather });
+                                    
+                                    continue;
+                                }
+                                
+                                cases.add({ target, sampleRate, blockSize, tempo, delayTime, riserLength, numChannels });
+                            }
+    
+    return cases;
+}
+
+bool Benchmark::run(std::ostream& output, double tolerance) const
+{
+    const auto baseline = loadBaseline();
+    bool withinTolerance = true;
+    
+    output << getCSVHeader() << std::endl;
+    
+    for (auto& benchmarkCase : createCases())
+    {
+        const auto measurement = measure(benchmarkCase);
+        const auto key = getCaseKey(benchmarkCase);
+
+//        the ratio to the baseline's ns per sample, above 1 is slower
+        juce::String ratio;
+        const auto baselineRow = baseline.find(key);
+        
+        if (baselineRow != baseline.end() && baselineRow->second > 0.0)
+        {
+            const double ratioToBaseline = measurement.nanosecondsPerSample / baselineRow->second;
+            ratio = juce::String(ratioToBaseline, 3);
+            
+            if (ratioToBaseline > 1.0 + tolerance)
+                withinTolerance = false;
+        }
+        
+//        the storage error is only measured for int16 storage on RiserLine itself
+        juce::String storageError;
+        
+        if (benchmarkCase.target == Target::riserLine && settings.riserStorage == RiserLineBase::RiserStorage::int16)
+            storageError = juce::String(measurement.storageErrorDb, 1);
+        
+        output << key
+               << "," << juce::String(measurement.nanosecondsPerSample, 3)
+               << "," << juce::String(measurement.realtimeFactor, 1)
+               << "," << (juce::uint64) measurement.footprintBytes
+               << "," << storageError
+               << "," << ratio << std::endl;
+    }
+    
+    return withinTolerance;
+}
+
+Benchmark::Measurement Benchmark::measure(const Case& benchmarkCase) const
+{
+    return benchmarkCase.target == Target::riserLine ? measureRiserLine(benchmarkCase)
+                                                     : measureProcessor(benchmarkCase);
+}
+
+Benchmark::Measurement Benchmark::measureRiserLine(const Case& benchmarkCase) const
+{
+    RiserLine<float> riserLine((float) benchmarkCase.delayTime, (float) benchmarkCase.riserLength);
+    riserLine.setRiserStorage(settings.riserStorage);
+    riserLine.setMemoryLimit(settings.memoryLimit);
+    
+    if (benchmarkCase.gather.function != nullptr)
+        riserLine.setGatherFunction(benchmarkCase.gather.function);
+    
+    riserLine.prepare((float) benchmarkCase.delayTime, (float) benchmarkCase.riserLength, 2.0f, 0.5f,
+                      benchmarkCase.tempo, benchmarkCase.sampleRate, benchmarkCase.numChannels);
+    
+    RiserLineBase::Params params;
+    params.delayTime = (float) benchmarkCase.delayTime;
+    params.riserLength = (float) benchmarkCase.riserLength;
+    params.feedback = 0.5f;
+    params.accelerateCap = 2.0f;
+    params.wetDryRatio = 0.5f;
+    params.tempo = benchmarkCase.tempo;
+    params.interpolation = settings.interpolation;
+    params.saturation = settings.saturation;
+    params.antialiasing = settings.antialiasing;
+    
+    juce::AudioBuffer<float> input(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    juce::AudioBuffer<float> output(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    fillWithNoise(input);
+    
+    auto measurement = time(benchmarkCase, [&]
+    {
+        juce::ScopedNoDenormals noDenormals;
+        riserLine.processBlock(input.getArrayOfReadPointers(), output.getArrayOfWritePointers(),
+                               benchmarkCase.numChannels, benchmarkCase.blockSize, params);
+    });
+    
+    measurement.footprintBytes = riserLine.getMemoryFootprint();
+    
+    if (settings.riserStorage == RiserLineBase::RiserStorage::int16)
+        measurement.storageErrorDb = measureStorageError(benchmarkCase);
+    
+    return measurement;
+}
+
+double Benchmark::measureStorageError(const Case& benchmarkCase) const
+{
+    RiserLineBase::Params params;
+    params.delayTime = (float) benchmarkCase.delayTime;
+    params.riserLength = (float) benchmarkCase.riserLength;
+    params.feedback = 0.5f;
+    params.accelerateCap = 2.0f;
+    params.wetDryRatio = 1.0f;
+    params.tempo = benchmarkCase.tempo;
+    params.interpolation = settings.interpolation;
+    params.saturation = settings.saturation;
+    params.antialiasing = settings.antialiasing;
+    
+    RiserLine<float> reference(params.delayTime, params.riserLength);
+    RiserLine<float> compact(params.delayTime, params.riserLength);
+    compact.setRiserStorage(RiserLineBase::RiserStorage::int16);
+    
+    for (auto* line : { &reference, &compact })
+    {
+        line->setMemoryLimit(settings.memoryLimit);
+        line->prepare(params.delayTime, params.riserLength, params.accelerateCap, params.feedback,
+                      benchmarkCase.tempo, benchmarkCase.sampleRate, benchmarkCase.numChannels);
+    }
+    
+    juce::AudioBuffer<float> input(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    juce::AudioBuffer<float> referenceOutput(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    juce::AudioBuffer<float> compactOutput(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    fillWithNoise(input);
+    
+    const int numBlocks = juce::jmax(1, (int) (settings.secondsPerCase * benchmarkCase.sampleRate / benchmarkCase.blockSize));
+    double signalEnergy = 0.0;
+    double errorEnergy = 0.0;
+    
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        reference.processBlock(input.getArrayOfReadPointers(), referenceOutput.getArrayOfWritePointers(),
+                               benchmarkCase.numChannels, benchmarkCase.blockSize, params);
+        compact.processBlock(input.getArrayOfReadPointers(), compactOutput.getArrayOfWritePointers(),
+                             benchmarkCase.numChannels, benchmarkCase.blockSize, params);
+        
+        for (int channel = 0; channel < benchmarkCase.numChannels; ++channel)
+        {
+            for (int i = 0; i < benchmarkCase.blockSize; ++i)
+            {
+                const double sample = referenceOutput.getSample(channel, i);
+                const double error = compactOutput.getSample(channel, i) - sample;
+                signalEnergy += sample * sample;
+                errorEnergy += error * error;
+            }
+        }
+    }
+    
+    if (signalEnergy <= 0.0 || errorEnergy <= 0.0)
+        return errorEnergy > 0.0 ? 0.0 : -std::numeric_limits<double>::infinity();
+    
+    return 10.0 * std::log10(errorEnergy / signalEnergy);
+}
+
+Benchmark::Measurement Benchmark::measureProcessor(const Case& benchmarkCase) const
+{
+    RiseUpAudioProcessor processor;
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(benchmarkCase.numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+    processor.setBusesLayout(layout);
+    
+    auto setParameter = [&processor] (const juce::String& parameterId, float value)
+    {
+        if (auto* parameter = processor.getAPVTS().getParameter(parameterId))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    };
+    
+    setParameter("delayTime", (float) benchmarkCase.delayTime);
+    setParameter("riserLength", (float) benchmarkCase.riserLength);
+    setParameter("feedback", 0.5f);
+    setParameter("accelerateCap", 2.0f);
+    setParameter("interpolation", (float) settings.interpolation);
+    setParameter("saturation", (float) settings.saturation);
+    setParameter("antialiasing", settings.antialiasing ? 1.0f : 0.0f);
+    processor.setMemoryLimit(settings.memoryLimit);
+    processor.setRiserStorage(settings.riserStorage);
+    processor.setEcoMode(settings.ecoMode);
+    
+    RenderPlayHead playHead(benchmarkCase.tempo, benchmarkCase.sampleRate);
+    processor.setPlayHead(&playHead);
+    processor.setRateAndBufferSizeDetails(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+    processor.prepareToPlay(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+    
+    juce::AudioBuffer<float> noise(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    juce::AudioBuffer<float> buffer(benchmarkCase.numChannels, benchmarkCase.blockSize);
+    juce::MidiBuffer midiMessages;
+    fillWithNoise(noise);
+
+//    processBlock() works in place, so every block starts from a fresh copy of the noise (the copy is timed with it,
+//    the same as a host handing over a new buffer)
+    auto measurement = time(benchmarkCase, [&]
+    {
+        buffer.makeCopyOf(noise, true);
+        processor.processBlock(buffer, midiMessages);
+        playHead.advance(benchmarkCase.blockSize);
+    });
+    
+    measurement.footprintBytes = processor.getMemoryFootprint();
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return measurement;
+}
+
+Benchmark::Measurement Benchmark::time(const Case& benchmarkCase, const std::function<void()>& processBlock) const
+{
+    const int numBlocks = juce::jmax(1, (int) (settings.secondsPerCase * benchmarkCase.sampleRate / benchmarkCase.blockSize));
+
+//    warm up the caches and the branch predictors before anything is timed
+    for (int block = 0; block < juce::jmax(1, numBlocks / 4); ++block)
+        processBlock();
+    
+    double fastestSeconds = std::numeric_limits<double>::max();
+    
+    for (int repeat = 0; repeat < juce::jmax(1, settings.numRepeats); ++repeat)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        
+        for (int block = 0; block < numBlocks; ++block)
+            processBlock();
+        
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        fastestSeconds = juce::jmin(fastestSeconds, seconds);
+    }
+    
+    const double numFrames = (double) numBlocks * benchmarkCase.blockSize;
+    
+    Measurement measurement;
+    measurement.nanosecondsPerSample = fastestSeconds * 1.0e9 / (numFrames * benchmarkCase.numChannels);
+    measurement.realtimeFactor = fastestSeconds > 0.0 ? numFrames / benchmarkCase.sampleRate / fastestSeconds : 0.0;
+    return measurement;
+}
+
+juce::String Benchmark::getCaseKey(const Case& benchmarkCase) const
+{
+    return getTargetName(benchmarkCase.target, settings.ecoMode)
+         + "," + juce::String((int) benchmarkCase.sampleRate)
+         + "," + juce::String(benchmarkCase.blockSize)
+         + "," + juce::String(benchmarkCase.tempo, 1)
+         + "," + juce::String(benchmarkCase.delayTime)
+         + "," + juce::String(benchmarkCase.riserLength)
+         + "," + juce::String(benchmarkCase.numChannels)
+         + "," + getInterpolationName(settings.interpolation, benchmarkCase.gather)
+         + "," + getStorageName(settings.riserStorage)
+         + "," + getSaturationName(settings.saturation, settings.antialiasing);
+}
+
+std::map<juce::String, double> Benchmark::loadBaseline() const
+{
+    std::map<juce::String, double> baseline;
+    
+    if (! settings.baselineFile.existsAsFile())
+        return baseline;
+    
+    juce::StringArray lines;
+    settings.baselineFile.readLines(lines);
+
+//    the first 10 columns are the key, the 11th is ns per sample
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        auto columns = juce::StringArray::fromTokens(lines[i], ",", "");
+        
+        if (columns.size() < 11)
+            continue;
+        
+        const auto key = columns.joinIntoString(",", 0, 10);
+        baseline[key] = columns[10].getDoubleValue();
+    }
+    
+    return baseline;
+}
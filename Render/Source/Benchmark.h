@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 2 Mar 2024 10:58:03am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+// Times RiserLine::processBlock and RiseUpAudioProcessor::processBlock over every combination of the sample rates,
+// block sizes, tempos and note lengths in the settings. Every case prints one CSV row in a fixed order, so two runs can be
+// diffed, or checked against an earlier run's CSV with 'baselineFile'.
+class Benchmark
+{
+public:
+    enum class Target
+    {
+        riserLine,
+        processor
+    };
+    
+    struct Settings
+    {
+        juce::Array<Target> targets { Target::riserLine, Target::processor };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> tempos { 40.0, 60.0, 90.0, 120.0, 150.0, 180.0, 240.0 };
+        juce::Array<int> delayTimes { 1, 2, 3, 4, 5 };       // the delayTime parameter indices
+        juce::Array<int> riserLengths { 3, 4, 5, 6, 7 };     // the riserLength parameter indices
+        juce::Array<int> channelCounts { 1, 2 };             // mono is the only layout the read-head kernel runs on
+        Interpolation::Quality interpolation = Interpolation::Quality::linear;
+        Saturation::Curve saturation = Saturation::Curve::hardClip;
+        bool antialiasing = false;
+        RiserLineBase::RiserStorage riserStorage = RiserLineBase::RiserStorage::float32;
+        size_t memoryLimit = 0;                               // per RiserLine or processor, 0 for no limit
+        RiseUpAudioProcessor::EcoMode ecoMode = RiseUpAudioProcessor::EcoMode::off;   // the processor target only
+        double secondsPerCase = 1.0;                          // audio rendered for every timed repeat
+        int numRepeats = 3;                                   // the fastest repeat is reported
+        juce::File baselineFile;                              // an earlier run's CSV to compare against
+    };
+    
+    struct Case
+    {
+        Target target;
+        double sampleRate;
+        int blockSize;
+        double tempo;
+        int delayTime;
+        int riserLength;
+        int numChannels;
+        ReadHeadKernel::NamedGather gather { nullptr, nullptr };    // the fastest the CPU supports unless one is named
+    };
+    
+    struct Measurement
+    {
+        double nanosecondsPerSample = 0.0;  // per sample of every channel
+        double realtimeFactor = 0.0;        // seconds of audio rendered per second taken
+        size_t footprintBytes = 0;
+        double storageErrorDb = 0.0;        // the difference int16 riser storage makes, relative to the float32 wet signal
+    };
+    
+    explicit Benchmark(const Settings& settings);
+    
+    // run every case and write the CSV to 'output'. returns false if a baseline was given and any case is more than
+    // 'tolerance' (e.g. 0.1 for 10%) slower than it
+    bool run(std::ostream& output, double tolerance = 0.1) const;
+    
+    juce::Array<Case> createCases() const;
+    Measurement measure(const Case& benchmarkCase) const;
+    
+    static juce::String getCSVHeader();
+
+private:
+    Measurement measureRiserLine(const Case& benchmarkCase) const;
+    Measurement measureProcessor(const Case& benchmarkCase) const;
+    
+    // run a float32 and an int16 RiserLine side by side over 'secondsPerCase' of noise and return the energy of the
+    // difference between their wet outputs relative to the float32 one, in dB
+    double measureStorageError(const Case& benchmarkCase) const;
+    
+    // time 'processBlock' over 'secondsPerCase' of audio 'numRepeats' times after a warm-up and keep the fastest
+    Measurement time(const Case& benchmarkCase, const std::function<void()>& processBlock) const;
+    
+    // the columns that identify a case, used to match rows against the baseline
+    juce::String getCaseKey(const Case& benchmarkCase) const;
+    
+    std::map<juce::String, double> loadBaseline() const;
+    
+    Settings settings;
+};
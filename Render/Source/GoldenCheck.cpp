@@ -0,0 +1,373 @@
+/*
+  ==============================================================================
+
+    GoldenCheck.cpp
+    Created: 8 Apr 2024 11:12:46am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "GoldenCheck.h"
+
+namespace
+{
+    const char* getSignalName(GoldenCheck::Signal signal)
+    {
+        switch (signal)
+        {
+            case GoldenCheck::Signal::impulses:  return "impulses";
+            case GoldenCheck::Signal::sweep:     return "sweep";
+            case GoldenCheck::Signal::noise:
+            default:                             return "noise";
+        }
+    }
+}
+
+GoldenCheck::GoldenCheck(const Settings& newSettings) : settings(newSettings)
+{
+}
+
+juce::Array<GoldenCheck::Case> GoldenCheck::createCases() const
+{
+    juce::Array<Case> cases;
+    const bool kernelRuns = settings.interpolation == Interpolation::Quality::linear && ! settings.doublePrecision;
+    const auto gathers = ReadHeadKernel::getSupportedGathers();
+    
+    for (auto signal : settings.signals)
+        for (auto tempo : settings.tempos)
+            for (auto delayTime : settings.delayTimes)
+                for (auto riserLength : settings.riserLengths)
+                    for (auto accelerateCap : settings.accelerateCaps)
+                        for (auto numChannels : settings.channelCounts)
+                        {
+                            numChannels = juce::jlimit(1, RiserLineBase::maxChannels, numChannels);
+                            cases.add({ signal, tempo, delayTime, riserLength, accelerateCap, numChannels });
+                            
+//                            the default gather writes the golden file, every gather the CPU has is checked against it
+                            if (kernelRuns && numChannels == 1)
+                                for (auto& gather : gathers)
+                                    cases.add({ signal, tempo, delayTime, riserLength, accelerateCap, numChannels, gather });
+                        }
+    
+    return cases;
+}
+
+juce::String GoldenCheck::getCaseName(const Case& goldenCase)
+{
+    return juce::String(getSignalName(goldenCase.signal))
+         + "_tempo" + juce::String(goldenCase.tempo, 1)
+         + "_delay" + juce::String(goldenCase.delayTime)
+         + "_riser" + juce::String(goldenCase.riserLength)
+         + "_cap" + juce::String(goldenCase.accelerateCap, 1)
+         + (goldenCase.numChannels == 1 ? "_mono" : "");
+}
+
+juce::String GoldenCheck::getDisplayName(const Case& goldenCase)
+{
+    const auto name = getCaseName(goldenCase);
+    return goldenCase.gather.name != nullptr ? name + " (" + goldenCase.gather.name + ")" : name;
+}
+
+juce::File GoldenCheck::getGoldenFile(const Case& goldenCase) const
+{
+    return settings.goldenDirectory.getChildFile(getCaseName(goldenCase) + ".wav");
+}
+
+int GoldenCheck::getRiserLengthInSamples(const Case& goldenCase) const
+{
+    NoteLengths noteLengths;
+    noteLengths.update(juce::jmax(goldenCase.tempo, RiserLineBase::minTempo), juce::AudioPlayHead::TimeSignature(), settings.sampleRate);
+    return noteLengths.getLengthInSamples((float) goldenCase.riserLength);
+}
+
+int GoldenCheck::write(std::ostream& output) const
+{
+    int numFailed = 0;
+    juce::int64 numBytes = 0;
+    juce::Array<Case> cases;
+    
+//    the cases with a named gather only check against the file their default gather case writes
+    for (auto& goldenCase : createCases())
+        if (goldenCase.gather.function == nullptr)
+            cases.add(goldenCase);
+    
+    for (auto& goldenCase : cases)
+    {
+        const auto file = getGoldenFile(goldenCase);
+        
+        if (! writeFile(file, render(goldenCase)))
+        {
+            ++numFailed;
+            output << "failed   can't write " << file.getFullPathName() << std::endl;
+            continue;
+        }
+        
+        numBytes += file.getSize();
+        output << "wrote    " << file.getFileName() << std::endl;
+    }
+    
+    output << cases.size() - numFailed << " of " << cases.size() << " golden files written to "
+           << settings.goldenDirectory.getFullPathName() << " (" << juce::File::descriptionOfSizeInBytes(numBytes) << ")" << std::endl;
+    
+    return numFailed;
+}
+
+int GoldenCheck::check(std::ostream& output) const
+{
+    int numFailed = 0;
+    float maxError = 0.0f;
+    const auto cases = createCases();
+    
+    for (auto& goldenCase : cases)
+    {
+        const auto file = getGoldenFile(goldenCase);
+        const auto actual = render(goldenCase);
+        juce::AudioBuffer<float> expected;
+        
+        Comparison comparison;
+        
+        if (readFile(file, expected))
+            comparison = compare(expected, actual);
+        
+        maxError = juce::jmax(maxError, comparison.maxError);
+        
+        if (comparison.passed())
+        {
+            output << "passed   " << getDisplayName(goldenCase) << " (max error " << juce::String(comparison.maxError, 9) << ")" << std::endl;
+            continue;
+        }
+        
+        ++numFailed;
+        output << "FAILED   " << getDisplayName(goldenCase) << ": ";
+        
+        if (! comparison.goldenFound)
+        {
+            output << "no golden file " << file.getFullPathName() << std::endl;
+        }
+        else if (! comparison.sameLength)
+        {
+            output << "the golden file has " << expected.getNumChannels() << " channels of " << expected.getNumSamples()
+                   << " samples, the render " << actual.getNumChannels() << " of " << actual.getNumSamples() << std::endl;
+        }
+        else
+        {
+//            where in the riser cycle it went wrong is usually what points at the cause (a switch, a wraparound, a reset)
+            const auto sample = comparison.firstDivergence;
+            const auto riserLength = juce::jmax(1, getRiserLengthInSamples(goldenCase));
+            
+            output << "diverges at sample " << sample << " (" << juce::String((double) sample / settings.sampleRate, 4) << " s, "
+                   << juce::String((double) (sample % riserLength) / riserLength, 3) << " into riser cycle " << sample / riserLength + 1
+                   << ") on channel " << comparison.channel
+                   << ": expected " << juce::String(comparison.expected, 9) << ", got " << juce::String(comparison.actual, 9)
+                   << " (max error " << juce::String(comparison.maxError, 9) << ")" << std::endl;
+        }
+    }
+    
+    output << cases.size() - numFailed << " of " << cases.size() << " cases match the golden files within "
+           << juce::String(settings.tolerance, 9) << " (max error " << juce::String(maxError, 9) << ")" << std::endl;
+    
+    return numFailed;
+}
+
+GoldenCheck::Comparison GoldenCheck::compare(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual) const
+{
+    Comparison comparison;
+    comparison.goldenFound = true;
+    comparison.sameLength = expected.getNumChannels() == actual.getNumChannels()
+                         && expected.getNumSamples() == actual.getNumSamples();
+    
+    if (! comparison.sameLength)
+        return comparison;
+    
+    for (int channel = 0; channel < expected.getNumChannels(); ++channel)
+    {
+        const auto* expectedSamples = expected.getReadPointer(channel);
+        const auto* actualSamples = actual.getReadPointer(channel);
+        
+        for (int i = 0; i < expected.getNumSamples(); ++i)
+        {
+//            a NaN never compares within the tolerance
+            const float error = std::abs(actualSamples[i] - expectedSamples[i]);
+            const bool withinTolerance = error <= settings.tolerance;
+            
+            if (withinTolerance)
+            {
+                comparison.maxError = juce::jmax(comparison.maxError, error);
+                continue;
+            }
+            
+            comparison.maxError = std::isnan(error) ? std::numeric_limits<float>::infinity() : juce::jmax(comparison.maxError, error);
+            
+            if (comparison.firstDivergence < 0 || i < comparison.firstDivergence)
+            {
+                comparison.firstDivergence = i;
+                comparison.channel = channel;
+                comparison.expected = expectedSamples[i];
+                comparison.actual = actualSamples[i];
+            }
+        }
+    }
+    
+    return comparison;
+}
+
+juce::AudioBuffer<float> GoldenCheck::render(const Case& goldenCase) const
+{
+    if (settings.doublePrecision)
+        return renderWithPrecision<double>(goldenCase);
+    
+    return renderWithPrecision<float>(goldenCase);
+}
+
+template <typename SampleType>
+juce::AudioBuffer<float> GoldenCheck::renderWithPrecision(const Case& goldenCase) const
+{
+    juce::ScopedNoDenormals noDenormals;
+    
+    const int numChannels = goldenCase.numChannels;
+    const int numSamples = (int) std::ceil(juce::jmax(settings.numRiserCycles * getRiserLengthInSamples(goldenCase),
+                                                      settings.minSeconds * settings.sampleRate));
+    
+    RiserLine<SampleType> riserLine((float) goldenCase.delayTime, (float) goldenCase.riserLength);
+    riserLine.prepare((float) goldenCase.delayTime, (float) goldenCase.riserLength, goldenCase.accelerateCap, 0.5f,
+                      goldenCase.tempo, settings.sampleRate, numChannels);
+    
+    if (goldenCase.gather.function != nullptr)
+        riserLine.setGatherFunction(goldenCase.gather.function);
+
+//    wet only, so nothing the riser does is masked by the dry signal
+    RiserLineBase::Params params;
+    params.delayTime = (float) goldenCase.delayTime;
+    params.riserLength = (float) goldenCase.riserLength;
+    params.feedback = 0.5f;
+    params.accelerateCap = goldenCase.accelerateCap;
+    params.wetDryRatio = 1.0f;
+    params.tempo = goldenCase.tempo;
+    params.interpolation = settings.interpolation;
+    
+    juce::AudioBuffer<SampleType> input;
+    input.makeCopyOf(createSignal(goldenCase.signal, numChannels, numSamples));
+    juce::AudioBuffer<SampleType> output(numChannels, numSamples);
+
+//    the same block sizes for every run, between 1 and maxBlockSize samples
+    juce::Random blockSizes(2207);
+    std::array<const SampleType*, RiserLineBase::maxChannels> inputPointers {};
+    std::array<SampleType*, RiserLineBase::maxChannels> outputPointers {};
+    
+    for (int start = 0; start < numSamples;)
+    {
+        const int numBlockSamples = juce::jmin(numSamples - start, 1 + blockSizes.nextInt(maxBlockSize));
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            inputPointers[(size_t) channel] = input.getReadPointer(channel, start);
+            outputPointers[(size_t) channel] = output.getWritePointer(channel, start);
+        }
+        
+        riserLine.processBlock(inputPointers.data(), outputPointers.data(), numChannels, numBlockSamples, params);
+        start += numBlockSamples;
+    }
+    
+//    double output is rounded to float, the golden files hold float samples either way
+    juce::AudioBuffer<float> result;
+    result.makeCopyOf(output);
+    return result;
+}
+
+juce::AudioBuffer<float> GoldenCheck::createSignal(Signal signal, int numChannels, int numSamples) const
+{
+    juce::AudioBuffer<float> mono(1, numSamples);
+    mono.clear();
+    auto* samples = mono.getWritePointer(0);
+    
+    switch (signal)
+    {
+        case Signal::impulses:
+        {
+//            a full scale impulse every 100ms, a few to every riser length
+            const int interval = juce::jmax(1, (int) (settings.sampleRate * 0.1));
+            
+            for (int i = 0; i < numSamples; i += interval)
+                samples[i] = 1.0f;
+            
+            break;
+        }
+        
+        case Signal::sweep:
+        {
+//            an exponential sine sweep from 20 Hz to just below Nyquist over the whole case
+            const double startFrequency = 20.0;
+            const double endFrequency = settings.sampleRate * 0.45;
+            const double duration = numSamples / settings.sampleRate;
+            const double rate = std::log(endFrequency / startFrequency);
+            
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double time = i / settings.sampleRate;
+                const double phase = juce::MathConstants<double>::twoPi * startFrequency * duration / rate
+                                   * (std::exp(time / duration * rate) - 1.0);
+                samples[i] = 0.5f * (float) std::sin(phase);
+            }
+            
+            break;
+        }
+        
+        case Signal::noise:
+        default:
+        {
+            juce::Random random(4408);
+            
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = random.nextFloat() - 0.5f;
+            
+            break;
+        }
+    }
+    
+    juce::AudioBuffer<float> buffer(numChannels, numSamples);
+    buffer.clear();
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const int offset = juce::jmin(numSamples, channel * 37);
+        buffer.copyFrom(channel, offset, mono, 0, 0, numSamples - offset);
+    }
+    
+    return buffer;
+}
+
+bool GoldenCheck::writeFile(const juce::File& file, const juce::AudioBuffer<float>& buffer) const
+{
+    file.deleteFile();
+    auto outputStream = file.createOutputStream();
+    
+    if (outputStream == nullptr)
+        return false;
+
+//    32-bit WAV is IEEE float, so the golden samples are exactly what RiserLine produced
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(outputStream.get(), settings.sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(), 32, {}, 0));
+    
+    if (writer == nullptr)
+        return false;
+    
+    outputStream.release();
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+bool GoldenCheck::readFile(const juce::File& file, juce::AudioBuffer<float>& buffer) const
+{
+    if (! file.existsAsFile())
+        return false;
+    
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(file.createInputStream().release(), true));
+    
+    if (reader == nullptr)
+        return false;
+    
+    buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+    return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
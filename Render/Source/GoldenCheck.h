@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    GoldenCheck.h
+    Created: 8 Apr 2024 11:12:46am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/RiserLine.h"
+
+// Renders fixed test signals (an impulse train, a sine sweep and noise) through RiserLine for every combination of the
+// tempos, delay times, riser lengths and accelerate caps in the settings, long enough to cross a riser switch. 'write'
+// keeps the output as 32-bit float WAV files in 'goldenDirectory', 'check' renders again and compares against them,
+// reporting the first sample of every case that differs by more than 'tolerance'. Optimisations to RiserLine should
+// pass the check against golden files written before them. Mono float cases with linear interpolation are checked once
+// per read-head kernel gather the CPU supports, all against the same file.
+class GoldenCheck
+{
+public:
+    enum class Signal
+    {
+        impulses,
+        sweep,
+        noise
+    };
+    
+    struct Settings
+    {
+        juce::File goldenDirectory;
+        juce::Array<Signal> signals { Signal::impulses, Signal::sweep, Signal::noise };
+        juce::Array<double> tempos { 90.0, 140.0, 200.0 };
+        juce::Array<int> delayTimes { 1, 2, 3, 4, 5 };                   // the delayTime parameter indices
+        juce::Array<int> riserLengths { 3, 4, 5, 6, 7 };                 // the riserLength parameter indices
+        juce::Array<float> accelerateCaps { 1.1f, 2.0f, 4.0f };
+        double sampleRate = 22050.0;                                     // low, the golden files of the full grid take ~300 MB
+        juce::Array<int> channelCounts { 1, 2 };                         // mono is the only layout the read-head kernel runs on
+        Interpolation::Quality interpolation = Interpolation::Quality::linear;
+        double numRiserCycles = 1.25;                                    // rendered per case, past the first riser switch
+        double minSeconds = 2.0;                                         // so short risers switch a few times
+        float tolerance = 1.0e-5f;                                       // the largest difference allowed from a golden sample
+        bool doublePrecision = false;                                    // render through RiserLine<double>, against the same files
+    };
+    
+    struct Case
+    {
+        Signal signal;
+        double tempo;
+        int delayTime;
+        int riserLength;
+        float accelerateCap;
+        int numChannels;
+        ReadHeadKernel::NamedGather gather { nullptr, nullptr };        // the fastest the CPU supports unless one is named
+    };
+    
+    // how a rendered case compares to its golden file
+    struct Comparison
+    {
+        bool goldenFound = false;
+        bool sameLength = false;
+        juce::int64 firstDivergence = -1;   // the first sample off by more than the tolerance, -1 if none is
+        int channel = 0;
+        float expected = 0.0f;
+        float actual = 0.0f;
+        float maxError = 0.0f;
+        
+        bool passed() const noexcept { return goldenFound && sameLength && firstDivergence < 0; }
+    };
+    
+    explicit GoldenCheck(const Settings& settings);
+    
+    // render every case into the golden directory and return the number of files that couldn't be written
+    int write(std::ostream& output) const;
+    
+    // render every case, compare it with its golden file and return the number of cases that failed
+    int check(std::ostream& output) const;
+    
+    juce::Array<Case> createCases() const;
+    
+    // the case's output, rendered in a fixed pattern of block sizes so chunk boundaries fall everywhere
+    juce::AudioBuffer<float> render(const Case& goldenCase) const;
+    
+    Comparison compare(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual) const;
+    
+    // the name of the case's golden file, which doesn't depend on the gather
+    static juce::String getCaseName(const Case& goldenCase);
+    
+    // the case name with the gather it's rendered with, if it names one
+    static juce::String getDisplayName(const Case& goldenCase);
+
+private:
+    juce::File getGoldenFile(const Case& goldenCase) const;
+    
+    // the riser length of a case in samples, to say where in the riser cycle a divergence is
+    int getRiserLengthInSamples(const Case& goldenCase) const;
+    
+    // the test signal, each channel 37 samples later than the one before so the channels differ
+    juce::AudioBuffer<float> createSignal(Signal signal, int numChannels, int numSamples) const;
+    
+    template <typename SampleType>
+    juce::AudioBuffer<float> renderWithPrecision(const Case& goldenCase) const;
+    
+    bool writeFile(const juce::File& file, const juce::AudioBuffer<float>& buffer) const;
+    bool readFile(const juce::File& file, juce::AudioBuffer<float>& buffer) const;
+    
+    static constexpr int maxBlockSize = 512;
+    
+    Settings settings;
+};
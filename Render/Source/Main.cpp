@@ -0,0 +1,527 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "Benchmark.h"
+#include "RealtimeCheck.h"
+#include "GoldenCheck.h"
+#include "RiserLineCheck.h"
+
+//==============================================================================
+static juce::Array<juce::File> findInputFiles(const juce::StringArray& paths)
+{
+    juce::Array<juce::File> inputFiles;
+    
+    for (auto& path : paths)
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+
+//        a directory renders every WAV and FLAC file directly inside it
+        if (file.isDirectory())
+            inputFiles.addArray(file.findChildFiles(juce::File::findFiles, false, OfflineRenderer::getSupportedWildcard()));
+        else if (file.existsAsFile())
+            inputFiles.add(file);
+        else
+            juce::ConsoleApplication::fail("can't find " + path);
+    }
+    
+    return inputFiles;
+}
+
+// split the arguments into --name=value options and everything else, skipping the command's own option
+static juce::StringPairArray getOptions(const juce::ArgumentList& args, const juce::String& commandOption, juce::StringArray& otherArguments)
+{
+    juce::StringPairArray options;
+    
+    for (auto& argument : args.arguments)
+    {
+        if (argument.text == commandOption)
+            continue;
+        
+        if (! argument.text.startsWith("--"))
+        {
+            otherArguments.add(argument.text);
+            continue;
+        }
+        
+        if (! argument.text.containsChar('='))
+            juce::ConsoleApplication::fail("options are given as --name=value, got " + argument.text);
+        
+        options.set(argument.text.substring(2).upToFirstOccurrenceOf("=", false, false),
+                    argument.text.fromFirstOccurrenceOf("=", false, false));
+    }
+    
+    return options;
+}
+
+// a memory limit given in megabytes
+static size_t getMemoryLimit(const juce::String& text)
+{
+    const auto megabytes = text.getDoubleValue();
+    
+    if (megabytes < 0.0)
+        juce::ConsoleApplication::fail("--memory-limit is a number of megabytes, got '" + text + "'");
+    
+    return (size_t) (megabytes * 1024.0 * 1024.0);
+}
+
+static RiserLineBase::RiserStorage getRiserStorage(const juce::String& text)
+{
+    if (text == "int16")
+        return RiserLineBase::RiserStorage::int16;
+    
+    if (text != "float32")
+        juce::ConsoleApplication::fail("--riser-storage is float32 or int16");
+    
+    return RiserLineBase::RiserStorage::float32;
+}
+
+static RiseUpAudioProcessor::EcoMode getEcoMode(const juce::String& text)
+{
+    if (text == "half")
+        return RiseUpAudioProcessor::EcoMode::half;
+    
+    if (text == "quarter")
+        return RiseUpAudioProcessor::EcoMode::quarter;
+    
+    if (text != "off")
+        juce::ConsoleApplication::fail("--eco is off, half or quarter");
+    
+    return RiseUpAudioProcessor::EcoMode::off;
+}
+
+static juce::String getMegabytes(size_t numBytes)
+{
+    return juce::String((double) numBytes / (1024.0 * 1024.0), 1) + " MB";
+}
+
+static void render(const juce::ArgumentList& args)
+{
+    OfflineRenderer::Settings settings;
+    int numThreads = juce::SystemStats::getNumCpus();
+    juce::StringArray inputPaths;
+    const auto options = getOptions(args, {}, inputPaths);
+    
+    for (auto& name : options.getAllKeys())
+    {
+        const auto value = options[name];
+        
+        if (name == "tempo")               settings.tempo = value.getDoubleValue();
+        else if (name == "threads")        numThreads = value.getIntValue();
+        else if (name == "block-size")     settings.blockSize = value.getIntValue();
+        else if (name == "tail")           settings.tailSeconds = juce::jmax(0.0, value.getDoubleValue());
+        else if (name == "output")         settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (name == "suffix")         settings.outputSuffix = value;
+        else if (name == "memory-limit")   settings.memoryLimit = getMemoryLimit(value);
+        else if (name == "riser-storage")  settings.riserStorage = getRiserStorage(value);
+        else if (name == "eco")            settings.ecoMode = getEcoMode(value);
+        else                               settings.parameterValues.set(name, value);  // anything else is a RiseUp parameter
+    }
+    
+    if (inputPaths.isEmpty())
+        juce::ConsoleApplication::fail("no input files, see --help");
+    
+    OfflineRenderer renderer(settings);
+    auto settingsChecked = renderer.checkSettings();
+    
+    if (settingsChecked.failed())
+        juce::ConsoleApplication::fail(settingsChecked.getErrorMessage());
+    
+    if (settings.outputDirectory != juce::File() && ! settings.outputDirectory.createDirectory())
+        juce::ConsoleApplication::fail("can't create " + settings.outputDirectory.getFullPathName());
+    
+    const auto inputFiles = findInputFiles(inputPaths);
+    int numFailed = 0;
+    
+    renderer.renderFiles(inputFiles, numThreads, [&numFailed] (const OfflineRenderer::RenderResult& result)
+    {
+        if (result.result.failed())
+        {
+            ++numFailed;
+            std::cerr << "failed   " << result.result.getErrorMessage() << std::endl;
+            return;
+        }
+        
+        const auto speed = result.secondsTaken > 0.0 ? result.secondsRendered / result.secondsTaken : 0.0;
+        std::cout << "rendered " << result.outputFile.getFullPathName()
+                  << " (" << juce::String(speed, 1) << "x realtime, " << getMegabytes(result.footprintBytes)
+                  << (result.memoryLimited ? " at the memory limit)" : ")") << std::endl;
+    });
+    
+    std::cout << inputFiles.size() - numFailed << " of " << inputFiles.size() << " files rendered" << std::endl;
+    
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " files failed");
+}
+
+// a comma separated list of numbers, e.g. "44100,96000"
+template <typename NumberType>
+static juce::Array<NumberType> getNumberList(const juce::String& text)
+{
+    juce::Array<NumberType> numbers;
+    
+    for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        if (token.trim().isNotEmpty())
+            numbers.add((NumberType) token.getDoubleValue());
+    
+    if (numbers.isEmpty())
+        juce::ConsoleApplication::fail("expected a comma separated list of numbers, got '" + text + "'");
+    
+    return numbers;
+}
+
+// a comma separated list of channel counts, each within what RiserLine supports
+static juce::Array<int> getChannelCounts(const juce::String& text)
+{
+    auto channelCounts = getNumberList<int>(text);
+    
+    for (auto& numChannels : channelCounts)
+        numChannels = juce::jlimit(1, RiserLineBase::maxChannels, numChannels);
+    
+    return channelCounts;
+}
+
+static void benchmark(const juce::ArgumentList& args)
+{
+    Benchmark::Settings settings;
+    juce::File outputFile;
+    double tolerance = 0.1;
+    juce::StringArray otherArguments;
+    const auto options = getOptions(args, "--benchmark", otherArguments);
+    
+    for (auto& name : options.getAllKeys())
+    {
+        const auto value = options[name];
+        
+        if (name == "rates")                settings.sampleRates = getNumberList<double>(value);
+        else if (name == "block-sizes")     settings.blockSizes = getNumberList<int>(value);
+        else if (name == "tempos")          settings.tempos = getNumberList<double>(value);
+        else if (name == "delay-times")     settings.delayTimes = getNumberList<int>(value);
+        else if (name == "riser-lengths")   settings.riserLengths = getNumberList<int>(value);
+        else if (name == "channels")        settings.channelCounts = getChannelCounts(value);
+        else if (name == "seconds")         settings.secondsPerCase = juce::jmax(0.01, value.getDoubleValue());
+        else if (name == "repeats")         settings.numRepeats = juce::jmax(1, value.getIntValue());
+        else if (name == "baseline")        settings.baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (name == "tolerance")       tolerance = value.getDoubleValue();
+        else if (name == "memory-limit")    settings.memoryLimit = getMemoryLimit(value);
+        else if (name == "riser-storage")   settings.riserStorage = getRiserStorage(value);
+        else if (name == "eco")             settings.ecoMode = getEcoMode(value);
+        else if (name == "output")          outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (name == "target")
+        {
+            if (value == "riserline")       settings.targets = { Benchmark::Target::riserLine };
+            else if (value == "processor")  settings.targets = { Benchmark::Target::processor };
+            else if (value != "both")       juce::ConsoleApplication::fail("--target is riserline, processor or both");
+        }
+        else if (name == "interpolation")
+        {
+            const auto quality = juce::StringArray { "linear", "hermite", "sinc" }.indexOf(value, true);
+            
+            if (quality < 0)
+                juce::ConsoleApplication::fail("--interpolation is linear, hermite or sinc");
+            
+            settings.interpolation = (Interpolation::Quality) quality;
+        }
+        else if (name == "saturation")
+        {
+            const auto curve = juce::StringArray { "hardclip", "softclip", "tanh" }.indexOf(value, true);
+            
+            if (curve < 0)
+                juce::ConsoleApplication::fail("--saturation is hardclip, softclip or tanh");
+            
+            settings.saturation = (Saturation::Curve) curve;
+        }
+        else if (name == "antialiasing")
+        {
+            if (value != "on" && value != "off")
+                juce::ConsoleApplication::fail("--antialiasing is on or off");
+            
+            settings.antialiasing = value == "on";
+        }
+        else
+        {
+            juce::ConsoleApplication::fail("unknown benchmark option --" + name);
+        }
+    }
+    
+    if (settings.baselineFile != juce::File() && ! settings.baselineFile.existsAsFile())
+        juce::ConsoleApplication::fail("can't find the baseline " + settings.baselineFile.getFullPathName());
+    
+    Benchmark bench(settings);
+    bool withinTolerance = true;
+    
+    if (outputFile == juce::File())
+    {
+        withinTolerance = bench.run(std::cout, tolerance);
+    }
+    else
+    {
+        std::ostringstream output;
+        withinTolerance = bench.run(output, tolerance);
+        
+        if (! outputFile.replaceWithText(juce::String(output.str())))
+            juce::ConsoleApplication::fail("can't write " + outputFile.getFullPathName());
+    }
+    
+    if (! withinTolerance)
+        juce::ConsoleApplication::fail("slower than the baseline by more than " + juce::String(tolerance * 100.0, 0) + "%");
+}
+
+static void realtimeCheck(const juce::ArgumentList& args)
+{
+    if (! RealtimeSafety::isEnabled())
+        juce::ConsoleApplication::fail("this build has no realtime hooks, use the Debug build (RISEUP_REALTIME_CHECKS=1)");
+    
+    RealtimeCheck::Settings settings;
+    juce::StringArray otherArguments;
+    const auto options = getOptions(args, "--realtime-check", otherArguments);
+    
+    for (auto& name : options.getAllKeys())
+    {
+        const auto value = options[name];
+        
+        if (name == "rate")             settings.sampleRate = juce::jmax(8000.0, value.getDoubleValue());
+        else if (name == "block-size")  settings.blockSize = juce::jlimit(16, 65536, value.getIntValue());
+        else if (name == "channels")    settings.numChannels = juce::jlimit(1, RiserLineBase::maxChannels, value.getIntValue());
+        else if (name == "blocks")      settings.numBlocksPerScenario = juce::jmax(1, value.getIntValue());
+        else if (name == "traces")      settings.maxReportsPerScenario = juce::jmax(0, value.getIntValue());
+        else                            juce::ConsoleApplication::fail("unknown realtime check option --" + name);
+    }
+    
+    const int numViolations = RealtimeCheck(settings).run(std::cout);
+    
+    if (numViolations > 0)
+        juce::ConsoleApplication::fail(juce::String(numViolations) + " realtime violations in processBlock");
+}
+
+static void riserLineCheck(const juce::ArgumentList& args)
+{
+    RiserLineCheck::Settings settings;
+    juce::StringArray otherArguments;
+    const auto options = getOptions(args, "--riserline-check", otherArguments);
+    
+    for (auto& name : options.getAllKeys())
+    {
+        const auto value = options[name];
+        
+        if (name == "rate")             settings.sampleRate = juce::jmax(8000.0, value.getDoubleValue());
+        else if (name == "channels")    settings.channelCounts = getChannelCounts(value);
+        else                            juce::ConsoleApplication::fail("unknown riserline check option --" + name);
+    }
+    
+    const int numFailed = RiserLineCheck(settings).run(std::cout);
+    
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " RiserLine checks failed");
+}
+
+// the settings shared by --golden-write and --golden-check, the golden directory is the one other argument
+static GoldenCheck::Settings getGoldenSettings(const juce::ArgumentList& args, const juce::String& commandOption)
+{
+    GoldenCheck::Settings settings;
+    juce::StringArray otherArguments;
+    const auto options = getOptions(args, commandOption, otherArguments);
+    
+    for (auto& name : options.getAllKeys())
+    {
+        const auto value = options[name];
+        
+        if (name == "rate")                     settings.sampleRate = juce::jmax(8000.0, value.getDoubleValue());
+        else if (name == "tempos")              settings.tempos = getNumberList<double>(value);
+        else if (name == "delay-times")         settings.delayTimes = getNumberList<int>(value);
+        else if (name == "riser-lengths")       settings.riserLengths = getNumberList<int>(value);
+        else if (name == "accelerate-caps")     settings.accelerateCaps = getNumberList<float>(value);
+        else if (name == "channels")            settings.channelCounts = getChannelCounts(value);
+        else if (name == "cycles")              settings.numRiserCycles = juce::jmax(0.01, value.getDoubleValue());
+        else if (name == "min-seconds")         settings.minSeconds = juce::jmax(0.0, value.getDoubleValue());
+        else if (name == "tolerance")           settings.tolerance = juce::jmax(0.0f, value.getFloatValue());
+        else if (name == "precision")
+        {
+            if (value != "float" && value != "double")
+                juce::ConsoleApplication::fail("--precision is float or double");
+            
+            settings.doublePrecision = value == "double";
+        }
+        else if (name == "signals")
+        {
+            settings.signals.clear();
+            
+            for (auto& token : juce::StringArray::fromTokens(value, ",", ""))
+            {
+                const auto signal = juce::StringArray { "impulses", "sweep", "noise" }.indexOf(token.trim(), true);
+                
+                if (signal < 0)
+                    juce::ConsoleApplication::fail("--signals is a list of impulses, sweep and noise");
+                
+                settings.signals.add((GoldenCheck::Signal) signal);
+            }
+        }
+        else if (name == "interpolation")
+        {
+            const auto quality = juce::StringArray { "linear", "hermite", "sinc" }.indexOf(value, true);
+            
+            if (quality < 0)
+                juce::ConsoleApplication::fail("--interpolation is linear, hermite or sinc");
+            
+            settings.interpolation = (Interpolation::Quality) quality;
+        }
+        else
+        {
+            juce::ConsoleApplication::fail("unknown golden option --" + name);
+        }
+    }
+    
+    if (otherArguments.size() != 1)
+        juce::ConsoleApplication::fail("expected the golden directory, see --help");
+    
+    settings.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(otherArguments[0]);
+    return settings;
+}
+
+static void goldenWrite(const juce::ArgumentList& args)
+{
+    const auto settings = getGoldenSettings(args, "--golden-write");
+    
+    if (! settings.goldenDirectory.createDirectory())
+        juce::ConsoleApplication::fail("can't create " + settings.goldenDirectory.getFullPathName());
+    
+    const int numFailed = GoldenCheck(settings).write(std::cout);
+    
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " golden files failed");
+}
+
+static void goldenCheck(const juce::ArgumentList& args)
+{
+    const auto settings = getGoldenSettings(args, "--golden-check");
+    
+    if (! settings.goldenDirectory.isDirectory())
+        juce::ConsoleApplication::fail("can't find the golden directory " + settings.goldenDirectory.getFullPathName());
+    
+    const int numFailed = GoldenCheck(settings).check(std::cout);
+    
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " cases differ from the golden files");
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+//    the processor's parameters expect a message manager, even though nothing here runs the message loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    const juce::String options = "Options:\n"
+                                 "  --tempo=<bpm>           host tempo the riser follows (default 120)\n"
+                                 "  --threads=<n>           files rendered at once (default: one per CPU)\n"
+                                 "  --block-size=<samples>  processing block size (default 1024)\n"
+                                 "  --tail=<seconds>        silence rendered after each file (default 0)\n"
+                                 "  --output=<directory>    where the rendered files go (default: next to the input)\n"
+                                 "  --suffix=<text>         added to the rendered file names (default _riseup)\n"
+                                 "  --memory-limit=<MB>     the most the buffers of each file's processor may take (default: no limit)\n"
+                                 "  --riser-storage=<type>  float32 or int16 (dithered, a quarter of the riser memory) (default float32)\n"
+                                 "  --eco=<mode>            off, half or quarter: the riser runs at that fraction of the rate (default off)\n"
+                                 "  --<parameter>=<value>   any RiseUp parameter by id, e.g. --feedback=0.6 --riserLength=6\n"
+                                 "                          --interpolation=Sinc --stereoLink=off\n";
+    
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage: RiseUpRender [options] <files or directories...>\n"
+                       "       RiseUpRender --benchmark [options]\n"
+                       "       RiseUpRender --realtime-check [options]\n"
+                       "       RiseUpRender --riserline-check [options]\n"
+                       "       RiseUpRender --golden-write [options] <directory>\n"
+                       "       RiseUpRender --golden-check [options] <directory>\n\n" + options, true);
+    app.addVersionCommand("--version|-v", "RiseUpRender " + juce::String(ProjectInfo::versionString));
+    
+    app.addDefaultCommand({ "",
+                            "[options] <files or directories...>",
+                            "Renders WAV and FLAC files through RiseUp, one file per thread",
+                            options,
+                            render });
+    
+    app.addCommand({ "--benchmark",
+                     "--benchmark [options]",
+                     "Times RiserLine and the processor over a grid of rates, block sizes, tempos and note lengths",
+                     "Writes one CSV row per case: ns per sample (per channel), realtime factor, the bytes held by the buffers and,\n"
+                     "with int16 riser storage, how far below RiserLine's float32 output the difference it makes is.\n"
+                     "Options:\n"
+                     "  --rates=<list>          sample rates (default 44100,48000,88200,96000,176400,192000)\n"
+                     "  --block-sizes=<list>    block sizes (default 16,32,...,4096)\n"
+                     "  --tempos=<list>         tempos (default 40,60,90,120,150,180,240)\n"
+                     "  --delay-times=<list>    delayTime indices (default 1,2,3,4,5)\n"
+                     "  --riser-lengths=<list>  riserLength indices (default 3,4,5,6,7)\n"
+                     "  --channels=<list>       channel counts (default 1,2; mono linear RiserLine cases are timed with\n"
+                     "                          every read-head kernel gather the CPU supports)\n"
+                     "  --interpolation=<name>  linear, hermite or sinc (default linear)\n"
+                     "  --saturation=<name>     hardclip, softclip or tanh (default hardclip)\n"
+                     "  --antialiasing=<on|off> ADAA on the saturation (default off)\n"
+                     "  --memory-limit=<MB>     the most the buffers may take (default: no limit)\n"
+                     "  --riser-storage=<type>  float32 or int16 (default float32)\n"
+                     "  --eco=<mode>            off, half or quarter, for the processor (default off)\n"
+                     "  --target=<name>         riserline, processor or both (default both)\n"
+                     "  --seconds=<seconds>     audio per timed repeat (default 1)\n"
+                     "  --repeats=<n>           timed repeats, the fastest is kept (default 3)\n"
+                     "  --output=<file>         write the CSV to a file instead of stdout\n"
+                     "  --baseline=<file>       a previous CSV to compare against, fails if any case is slower\n"
+                     "  --tolerance=<ratio>     how much slower than the baseline is allowed (default 0.1)",
+                     benchmark });
+    
+    app.addCommand({ "--realtime-check",
+                     "--realtime-check [options]",
+                     "Fails if processBlock allocates, frees, locks or blocks (Debug builds only)",
+                     "Runs the processor through automation, note length, tempo, interpolation and block size changes and\n"
+                     "reports every allocation, free, lock or blocking call made inside processBlock with a stack trace.\n"
+                     "Options:\n"
+                     "  --rate=<hz>             sample rate (default 48000)\n"
+                     "  --block-size=<samples>  prepared block size (default 256)\n"
+                     "  --channels=<n>          channels (default 2)\n"
+                     "  --blocks=<n>            blocks run per scenario (default 400)\n"
+                     "  --traces=<n>            stack traces printed per failing scenario (default 3)",
+                     realtimeCheck });
+    
+    app.addCommand({ "--riserline-check",
+                     "--riserline-check [options]",
+                     "Fails if RiserLine misbehaves in the edge cases that have broken it before",
+                     "Runs RiserLine through riser switches, buffer resizes and host positions at awkward moments and checks its\n"
+                     "read pointers and output rather than comparing against golden files.\n"
+                     "Options:\n"
+                     "  --rate=<hz>             sample rate (default 44100)\n"
+                     "  --channels=<list>       channel counts (default 1,2)",
+                     riserLineCheck });
+    
+    const juce::String goldenOptions = "Options (the same for writing and checking):\n"
+                                       "  --signals=<list>          impulses, sweep and noise (default all three)\n"
+                                       "  --tempos=<list>           tempos (default 90,140,200)\n"
+                                       "  --delay-times=<list>      delayTime indices (default 1,2,3,4,5)\n"
+                                       "  --riser-lengths=<list>    riserLength indices (default 3,4,5,6,7)\n"
+                                       "  --accelerate-caps=<list>  accelerateCap values (default 1.1,2,4)\n"
+                                       "  --rate=<hz>               sample rate (default 22050)\n"
+                                       "  --channels=<list>         channel counts (default 1,2; mono linear float cases are checked with\n"
+                                       "                            every read-head kernel gather the CPU supports)\n"
+                                       "  --interpolation=<name>    linear, hermite or sinc (default linear)\n"
+                                       "  --cycles=<n>              riser lengths rendered per case (default 1.25, past the first switch)\n"
+                                       "  --min-seconds=<seconds>   the least audio rendered per case (default 2)\n"
+                                       "  --tolerance=<value>       the largest difference allowed from a golden sample (default 0.00001)\n"
+                                       "  --precision=<name>        float or double, the RiserLine the cases render through (default float)";
+    
+    app.addCommand({ "--golden-write",
+                     "--golden-write [options] <directory>",
+                     "Renders test signals through RiserLine and keeps the output as golden files",
+                     "Writes one 32-bit float WAV per combination of signal, tempo, delay time, riser length and accelerate cap.\n"
+                     "Write them before optimising RiserLine and check against them after.\n" + goldenOptions,
+                     goldenWrite });
+    
+    app.addCommand({ "--golden-check",
+                     "--golden-check [options] <directory>",
+                     "Fails if RiserLine's output differs from the golden files by more than the tolerance",
+                     "Renders every case again with the options the golden files were written with, and reports the first\n"
+                     "sample, channel and point in the riser cycle where each failing case diverges.\n" + goldenOptions,
+                     goldenCheck });
+    
+    return app.findAndRunCommand(argc, argv);
+}
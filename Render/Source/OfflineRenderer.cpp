@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 24 Feb 2024 3:12:55pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+//==============================================================================
+class OfflineRenderer::RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(const OfflineRenderer& owner, const juce::File& file)
+        : juce::ThreadPoolJob("Render " + file.getFileName()), renderer(owner), inputFile(file)
+    {
+    }
+    
+    JobStatus runJob() override
+    {
+        result = renderer.renderFile(inputFile);
+        return jobHasFinished;
+    }
+    
+    RenderResult result;
+
+private:
+    const OfflineRenderer& renderer;
+    juce::File inputFile;
+};
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(const Settings& newSettings) : settings(newSettings)
+{
+    formatManager.registerBasicFormats();
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+juce::Result OfflineRenderer::checkSettings() const
+{
+    if (settings.tempo < RiserLineBase::minTempo || settings.tempo > 999.0)
+        return juce::Result::fail("the tempo must be between " + juce::String(RiserLineBase::minTempo) + " and 999 BPM");
+    
+    if (settings.blockSize < 16 || settings.blockSize > 65536)
+        return juce::Result::fail("the block size must be between 16 and 65536 samples");
+    
+    RiseUpAudioProcessor processor;
+    return applyParameters(processor);
+}
+
+juce::Array<OfflineRenderer::RenderResult> OfflineRenderer::renderFiles(const juce::Array<juce::File>& inputFiles, int numThreads,
+                                                                        std::function<void (const RenderResult&)> onFileFinished) const
+{
+//    the jobs have to outlive the pool, which waits for any running job when it is destroyed
+    juce::OwnedArray<RenderJob> jobs;
+    juce::ThreadPool pool(juce::jlimit(1, juce::jmax(1, inputFiles.size()), numThreads));
+    
+    for (auto& file : inputFiles)
+        pool.addJob(jobs.add(new RenderJob(*this, file)), false);
+    
+    juce::Array<RenderResult> results;
+    
+    for (auto* job : jobs)
+    {
+        pool.waitForJobToFinish(job, -1);
+        results.add(job->result);
+        
+        if (onFileFinished != nullptr)
+            onFileFinished(job->result);
+    }
+    
+    return results;
+}
+
+OfflineRenderer::RenderResult OfflineRenderer::renderFile(const juce::File& inputFile) const
+{
+    RenderResult renderResult;
+    renderResult.inputFile = inputFile;
+    renderResult.outputFile = getOutputFileFor(inputFile);
+    
+    auto fail = [&renderResult] (const juce::String& message)
+    {
+        renderResult.result = juce::Result::fail(renderResult.inputFile.getFileName() + ": " + message);
+        return renderResult;
+    };
+    
+    if (renderResult.outputFile == inputFile)
+        return fail("the output would overwrite the input, set an output directory or suffix");
+    
+    auto reader = createReader(inputFile);
+    
+    if (reader == nullptr)
+        return fail("not a readable WAV or FLAC file");
+    
+    const int numChannels = (int) reader->numChannels;
+    const double sampleRate = reader->sampleRate;
+
+//    the processor takes the channel layout of the file, anything RiseUp can't run is reported rather than remixed
+    RiseUpAudioProcessor processor;
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    
+    if (! processor.setBusesLayout(layout))
+        return fail("RiseUp can't process " + juce::String(numChannels) + " channels");
+    
+    auto parametersApplied = applyParameters(processor);
+    
+    if (parametersApplied.failed())
+        return fail(parametersApplied.getErrorMessage());
+    
+    processor.setMemoryLimit(settings.memoryLimit);
+    processor.setRiserStorage(settings.riserStorage);
+    processor.setEcoMode(settings.ecoMode);
+    
+    RenderPlayHead playHead(settings.tempo, sampleRate);
+    processor.setPlayHead(&playHead);
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+    processor.prepareToPlay(sampleRate, settings.blockSize);
+    
+    renderResult.footprintBytes = processor.getMemoryFootprint();
+    renderResult.memoryLimited = processor.isMemoryLimited();
+
+//    write in the format of the input, at its bit depth if the format can take it
+    auto* format = formatManager.findFormatForFileExtension(inputFile.getFileExtension());
+    int bitsPerSample = (int) reader->bitsPerSample;
+    
+    if (! format->getPossibleBitDepths().contains(bitsPerSample))
+        bitsPerSample = 24;
+    
+    renderResult.outputFile.deleteFile();
+    auto outputStream = renderResult.outputFile.createOutputStream();
+    
+    if (outputStream == nullptr)
+        return fail("can't write " + renderResult.outputFile.getFullPathName());
+    
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(outputStream.get(), sampleRate, (unsigned int) numChannels,
+                                                                            bitsPerSample, reader->metadataValues, 0));
+    
+    if (writer == nullptr)
+        return fail("can't create a " + format->getFormatName() + " writer");
+    
+    outputStream.release();
+    
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const auto lengthToWrite = reader->lengthInSamples + (juce::int64) (settings.tailSeconds * sampleRate);
+
+//    the output comes out the processor's latency late, so that much more is rendered and the start of it left out
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    const auto lengthToRender = lengthToWrite + latency;
+    
+    juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    juce::MidiBuffer midiMessages;
+    
+    for (juce::int64 position = 0; position < lengthToRender; position += settings.blockSize)
+    {
+        const int numSamples = (int) juce::jmin((juce::int64) settings.blockSize, lengthToRender - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+//        past the end of the file the reader fills the buffer with silence, which renders the tail
+        reader->read(&buffer, 0, numSamples, position, true, true);
+        
+        processor.processBlock(buffer, midiMessages);
+        playHead.advance(numSamples);
+        midiMessages.clear();
+        
+        const int numLatencySamples = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, latency - position);
+        
+        if (! writer->writeFromAudioSampleBuffer(buffer, numLatencySamples, numSamples - numLatencySamples))
+            return fail("writing " + renderResult.outputFile.getFileName() + " failed");
+    }
+    
+    writer.reset();
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    
+    renderResult.secondsRendered = (double) lengthToWrite / sampleRate;
+    renderResult.secondsTaken = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    return renderResult;
+}
+
+juce::File OfflineRenderer::getOutputFileFor(const juce::File& inputFile) const
+{
+    auto directory = settings.outputDirectory == juce::File() ? inputFile.getParentDirectory() : settings.outputDirectory;
+    return directory.getChildFile(inputFile.getFileNameWithoutExtension() + settings.outputSuffix + inputFile.getFileExtension());
+}
+
+std::unique_ptr<juce::AudioFormatReader> OfflineRenderer::createReader(const juce::File& inputFile) const
+{
+    auto* format = formatManager.findFormatForFileExtension(inputFile.getFileExtension());
+    
+    if (format == nullptr)
+        return nullptr;
+
+//    a mapped file is paged in as the blocks are read, so nothing is loaded up front and the OS can drop pages already rendered
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(inputFile));
+    
+    if (mappedReader != nullptr && mappedReader->mapEntireFile())
+        return mappedReader;
+
+//    FLAC has no mapped reader, so it is decoded from a buffered file stream instead
+    if (auto inputStream = inputFile.createInputStream())
+        return std::unique_ptr<juce::AudioFormatReader>(format->createReaderFor(inputStream.release(), true));
+    
+    return nullptr;
+}
+
+juce::Result OfflineRenderer::applyParameters(RiseUpAudioProcessor& processor) const
+{
+    auto& apvts = processor.getAPVTS();
+    
+    for (auto& parameterId : settings.parameterValues.getAllKeys())
+    {
+        auto* parameter = apvts.getParameter(parameterId);
+        
+        if (parameter == nullptr)
+            return juce::Result::fail("unknown parameter '" + parameterId + "'");
+
+//        the text goes through the parameter's own parsing, so choices can be given by name ("Sinc") and switches as on/off
+        parameter->setValueNotifyingHost(parameter->getValueForText(settings.parameterValues[parameterId]));
+    }
+    
+    return juce::Result::ok();
+}
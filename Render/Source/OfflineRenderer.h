@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 24 Feb 2024 3:12:48pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "RenderPlayHead.h"
+
+// Renders audio files through RiseUpAudioProcessor without a host, as fast as the CPU allows.
+// Every file is its own job on a thread pool with its own processor, and the input is streamed a block at a time
+// (memory-mapped for WAV/AIFF, streamed from disk for FLAC) instead of being loaded whole.
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        double tempo = 120.0;
+        int blockSize = 1024;
+        double tailSeconds = 0.0;                   // silence rendered after the end of each file
+        juce::StringPairArray parameterValues;      // APVTS parameter id -> value text, e.g. "feedback" -> "0.6"
+        juce::File outputDirectory;                 // next to each input file when not set
+        juce::String outputSuffix = "_riseup";
+        size_t memoryLimit = 0;                     // the most the processor's buffers may take, 0 for no limit
+        RiserLineBase::RiserStorage riserStorage = RiserLineBase::RiserStorage::float32;
+        RiseUpAudioProcessor::EcoMode ecoMode = RiseUpAudioProcessor::EcoMode::off;
+    };
+    
+    struct RenderResult
+    {
+        juce::File inputFile;
+        juce::File outputFile;
+        juce::Result result = juce::Result::ok();
+        double secondsRendered = 0.0;
+        double secondsTaken = 0.0;
+        size_t footprintBytes = 0;                  // the bytes held by the processor's buffers
+        bool memoryLimited = false;                 // the memory limit cut the longest note lengths short
+    };
+    
+    explicit OfflineRenderer(const Settings& settings);
+    ~OfflineRenderer();
+    
+    // check that every parameter in the settings exists and the tempo and block size are usable
+    juce::Result checkSettings() const;
+    
+    // render every file on 'numThreads' threads, 'onFileFinished' is called on this thread in input order
+    juce::Array<RenderResult> renderFiles(const juce::Array<juce::File>& inputFiles, int numThreads,
+                                          std::function<void (const RenderResult&)> onFileFinished = nullptr) const;
+    
+    // render one file on the calling thread
+    RenderResult renderFile(const juce::File& inputFile) const;
+    
+    juce::File getOutputFileFor(const juce::File& inputFile) const;
+    
+    // the file extensions of the formats the renderer reads and writes
+    static juce::String getSupportedWildcard() { return "*.wav;*.flac"; }
+
+private:
+    class RenderJob;
+    
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& inputFile) const;
+    juce::Result applyParameters(RiseUpAudioProcessor& processor) const;
+    
+    Settings settings;
+    juce::AudioFormatManager formatManager;
+    
+    JUCE_DECLARE_NON_COPYABLE (OfflineRenderer)
+};
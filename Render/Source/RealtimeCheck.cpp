@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Created: 9 Mar 2024 4:05:44pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+RealtimeCheck::RealtimeCheck(const Settings& newSettings) : settings(newSettings)
+{
+}
+
+void RealtimeCheck::setParameter(RiseUpAudioProcessor& processor, const juce::String& parameterId, float value)
+{
+    if (auto* parameter = processor.getAPVTS().getParameter(parameterId))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+juce::Array<RealtimeCheck::Scenario> RealtimeCheck::createScenarios() const
+{
+    juce::Array<Scenario> scenarios;
+    
+    scenarios.add({ "steady state", nullptr });
+    
+    scenarios.add({ "automation", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        const float phase = (float) (block % 64) / 64.0f;
+        setParameter(processor, "feedback", phase);
+        setParameter(processor, "wetDryRatio", 1.0f - phase);
+        setParameter(processor, "accelerateCap", 1.1f + 2.9f * phase);
+    }});
+
+//    every change of note length moves the buffer sizes and starts a crossfade
+    scenarios.add({ "note length changes", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 8 == 0)
+        {
+            setParameter(processor, "delayTime", (float) (1 + (block / 8) % 5));
+            setParameter(processor, "riserLength", (float) (3 + (block / 40) % 5));
+        }
+    }});
+    
+    scenarios.add({ "tempo changes", [] (RiseUpAudioProcessor&, RenderPlayHead& playHead, int block)
+    {
+        playHead.setTempo(40.0 + (block % 100) * 2.0);
+    }});
+    
+    scenarios.add({ "interpolation switching", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 10 == 0)
+            setParameter(processor, "interpolation", (float) ((block / 10) % 3));
+    }});
+
+//    the shortest riser at the fastest tempo switches riser buffers every few blocks
+    scenarios.add({ "riser switches", [] (RiseUpAudioProcessor& processor, RenderPlayHead& playHead, int block)
+    {
+        if (block == 0)
+        {
+            setParameter(processor, "delayTime", 1.0f);
+            setParameter(processor, "riserLength", 3.0f);
+            playHead.setTempo(240.0);
+        }
+    }});
+    
+//    voices come and go from the pool without allocating
+    scenarios.add({ "voice changes", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 5 == 0)
+        {
+            setParameter(processor, "voices", (float) (1 + (block / 5) % 8));
+            setParameter(processor, "voiceSpread", (float) ((block / 40) % 3) * 0.5f);
+        }
+    }});
+    
+//    the antialiasing starts over whenever the curve changes
+    scenarios.add({ "saturation switching", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 10 == 0)
+        {
+            setParameter(processor, "saturation", (float) ((block / 10) % 3));
+            setParameter(processor, "antialiasing", (float) ((block / 30) % 2));
+        }
+    }});
+    
+//    programs switch every setting at once behind a fade, including the note lengths and the voices
+    scenarios.add({ "program changes", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 15 == 0)
+            processor.setCurrentProgram((block / 15) % processor.getNumPrograms());
+    }});
+    
+//    the editor's telemetry, read here every other block (outside processBlock) so the FIFO both fills up and drains
+    scenarios.add({ "telemetry", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        auto& telemetry = processor.getTelemetry();
+        telemetry.setActive(true);
+        
+        if (block % 2 == 0)
+        {
+            std::array<Telemetry::Frame, 32> frames;
+            telemetry.pop(frames.data(), (int) frames.size());
+        }
+    }});
+    
+//    the RiserLines are rebuilt for the stereo link on the message thread, processBlock() only leaves a flag for it
+    scenarios.add({ "stereo link switching", [] (RiseUpAudioProcessor& processor, RenderPlayHead&, int block)
+    {
+        if (block % 20 == 0)
+            setParameter(processor, "stereoLink", (float) ((block / 20) % 2 == 0 ? 0 : 1));
+    }});
+    
+    scenarios.add({ "host block size changes", nullptr, true });
+    
+    return scenarios;
+}
+
+std::vector<RealtimeSafety::Violation> RealtimeCheck::runScenario(const Scenario& scenario) const
+{
+    RiseUpAudioProcessor processor;
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(settings.numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+    processor.setBusesLayout(layout);
+    
+    RenderPlayHead playHead(120.0, settings.sampleRate);
+    processor.setPlayHead(&playHead);
+    processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+    processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+    
+    juce::AudioBuffer<float> buffer(settings.numChannels, settings.blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Random random(4408);
+
+//    anything the set up above left behind isn't processBlock's doing
+    RealtimeSafety::takeViolations();
+    
+    for (int block = 0; block < settings.numBlocksPerScenario; ++block)
+    {
+        if (scenario.change != nullptr)
+            scenario.change(processor, playHead, block);
+
+//        hosts can hand over any number of samples up to the prepared block size
+        const int numSamples = scenario.varyBlockSize ? 1 + random.nextInt(settings.blockSize) : settings.blockSize;
+        buffer.setSize(settings.numChannels, numSamples, false, false, true);
+        
+        for (int channel = 0; channel < settings.numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+        
+        processor.processBlock(buffer, midiMessages);
+        playHead.advance(numSamples);
+    }
+    
+    auto violations = RealtimeSafety::takeViolations();
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return violations;
+}
+
+int RealtimeCheck::checkHooks(std::ostream& output) const
+{
+    if (! RealtimeSafety::isEnabled())
+        return 0;
+    
+   #if JUCE_LINUX
+    juce::AudioBuffer<float> buffer(settings.numChannels, 16);
+    RealtimeSafety::takeViolations();
+    
+    {
+        RealtimeSafety::ScopedRealtimeSection realtimeSection;
+        buffer.setSize(settings.numChannels, settings.blockSize * 16);
+    }
+    
+    const auto violations = RealtimeSafety::takeViolations();
+    const bool caught = std::any_of(violations.begin(), violations.end(), [] (const RealtimeSafety::Violation& violation)
+    {
+        return violation.type == RealtimeSafety::Violation::Type::allocation;
+    });
+    
+    if (caught)
+    {
+        output << "PASS  hooks catch AudioBuffer::setSize" << std::endl;
+        return 0;
+    }
+    
+    output << "FAIL  hooks catch AudioBuffer::setSize: the allocation wasn't reported, so no scenario below can be trusted" << std::endl;
+    return 1;
+   #else
+//    only operator new and delete are caught away from Linux, which AudioBuffer doesn't use
+    juce::ignoreUnused(output);
+    return 0;
+   #endif
+}
+
+int RealtimeCheck::run(std::ostream& output) const
+{
+    int numViolations = checkHooks(output);
+    
+    for (auto& scenario : createScenarios())
+    {
+        const auto violations = runScenario(scenario);
+        numViolations += (int) violations.size();
+        
+        if (violations.empty())
+        {
+            output << "PASS  " << scenario.name << std::endl;
+            continue;
+        }
+        
+        output << "FAIL  " << scenario.name << ": " << (int) violations.size() << " violations" << std::endl;
+        
+        for (int i = 0; i < juce::jmin((int) violations.size(), settings.maxReportsPerScenario); ++i)
+        {
+            output << "      " << RealtimeSafety::getDescription(violations[(size_t) i]) << std::endl
+                   << violations[(size_t) i].stackTrace << std::endl;
+        }
+    }
+    
+    return numViolations;
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    Created: 9 Mar 2024 4:05:37pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeSafety.h"
+#include "RenderPlayHead.h"
+
+// Runs RiseUpAudioProcessor::processBlock through the situations that have caused dropouts: automation, note length and
+// tempo changes that resize the buffers, interpolation and saturation switches, riser switches, voice count changes and changing host block sizes.
+// With the RealtimeSafety hooks built in, every allocation, free, lock or blocking call made inside processBlock
+// is reported with its stack trace.
+class RealtimeCheck
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int numChannels = 2;
+        int numBlocksPerScenario = 400;
+        int maxReportsPerScenario = 3;      // the stack traces printed for each failing scenario
+    };
+    
+    explicit RealtimeCheck(const Settings& settings);
+    
+    // run every scenario, write the report to 'output' and return the number of violations found (one more if the
+    // hooks don't catch the canary)
+    int run(std::ostream& output) const;
+
+private:
+    // changes made between blocks, from the host's side of processBlock (so they are not checked themselves)
+    using BlockChange = std::function<void (RiseUpAudioProcessor& processor, RenderPlayHead& playHead, int block)>;
+    
+    struct Scenario
+    {
+        juce::String name;
+        BlockChange change;
+        bool varyBlockSize = false;
+    };
+    
+    juce::Array<Scenario> createScenarios() const;
+    std::vector<RealtimeSafety::Violation> runScenario(const Scenario& scenario) const;
+    
+    // the canary run before the scenarios: resizing an AudioBuffer (malloc, not operator new) inside a realtime section
+    // has to be reported, or a passing scenario means nothing. Returns the number of failures, 0 or 1.
+    int checkHooks(std::ostream& output) const;
+    
+    static void setParameter(RiseUpAudioProcessor& processor, const juce::String& parameterId, float value);
+    
+    Settings settings;
+};
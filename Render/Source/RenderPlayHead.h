@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    RenderPlayHead.h
+    Created: 2 Mar 2024 10:41:27am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Stands in for the host transport when RiseUp runs without one: a fixed tempo in 4/4, always playing,
+// moving forward by the samples rendered. The PPQ position is counted up block by block, so a tempo change
+// doesn't look like the transport jumping.
+class RenderPlayHead  : public juce::AudioPlayHead
+{
+public:
+    RenderPlayHead(double bpm, double rate) : tempo(bpm), sampleRate(rate) {}
+    
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm(tempo);
+        info.setTimeSignature(TimeSignature());
+        info.setTimeInSamples(position);
+        info.setTimeInSeconds((double) position / sampleRate);
+        info.setPpqPosition(ppqPosition);
+        info.setPpqPositionOfLastBarStart(std::floor(ppqPosition / 4.0) * 4.0);
+        info.setIsPlaying(true);
+        return info;
+    }
+    
+    void advance(int numSamples)
+    {
+        position += numSamples;
+        ppqPosition += numSamples / sampleRate * tempo / 60.0;
+    }
+    
+    void setTempo(double newTempo) { tempo = newTempo; }
+
+private:
+    double tempo;
+    double sampleRate;
+    juce::int64 position = 0;
+    double ppqPosition = 0.0;
+};
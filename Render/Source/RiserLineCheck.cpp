@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    RiserLineCheck.cpp
+    Created: 15 Apr 2024 10:27:53am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RiserLineCheck.h"
+
+RiserLineCheck::RiserLineCheck(const Settings& newSettings) : settings(newSettings)
+{
+}
+
+juce::Array<RiserLineCheck::Check> RiserLineCheck::createChecks() const
+{
+    juce::Array<Check> checks;
+    
+    checks.add({ "resize right after a riser switch", [this] (int numChannels) { return checkResizeAfterRiserSwitch(numChannels); } });
+    checks.add({ "alignment of a 7/4 riser at 40 BPM", [this] (int numChannels) { return checkAlignmentOfShortRiser(numChannels, 40.0, 7, 0); } });
+    checks.add({ "alignment under a memory limit", [this] (int numChannels) { return checkAlignmentOfShortRiser(numChannels, 120.0, 4, 1 << 20); } });
+    
+    for (auto blockSize : { 1000, 1500, 0 })
+    {
+        const auto name = "processor alignment in " + (blockSize > 0 ? juce::String(blockSize) + " sample" : juce::String("random")) + " host blocks";
+        checks.add({ name, [this, blockSize] (int numChannels) { return checkProcessorAlignment(numChannels, blockSize); } });
+    }
+    
+    return checks;
+}
+
+juce::String RiserLineCheck::checkResizeAfterRiserSwitch(int numChannels) const
+{
+//    a tempo the note lengths don't divide evenly at, so the delay write pointer isn't back at 0 when the riser switches
+    RiserLineBase::Params params;
+    params.delayTime = 1.0f;
+    params.riserLength = 3.0f;
+    params.tempo = 233.0;
+    
+    RiserLine<float> riserLine(params.delayTime, params.riserLength);
+    riserLine.prepare(params.delayTime, params.riserLength, params.accelerateCap, params.feedback, params.tempo, settings.sampleRate, numChannels);
+
+//    one sample blocks, so every riser switch falls on the last sample of one
+    juce::AudioBuffer<float> buffer(numChannels, 1);
+    juce::Random random(2002);
+    const int numSamples = (int) (settings.sampleRate * 4.0);
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto numRiserSwitches = riserLine.getNumRiserSwitches();
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.setSample(channel, 0, random.nextFloat() - 0.5f);
+        
+        riserLine.processBlock(buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), numChannels, 1, params);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (! std::isfinite(buffer.getSample(channel, 0)))
+                return "non-finite output at sample " + juce::String(i);
+        
+        if (riserLine.getNumRiserSwitches() == numRiserSwitches)
+            continue;
+
+//        an empty block resizes the buffers without reading anything, so the crossfade's first read position can be seen
+        params.delayTime = params.delayTime == 1.0f ? 2.0f : 1.0f;
+        riserLine.processBlock(buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), numChannels, 0, params);
+        
+        const auto crossfadeReadPosition = riserLine.getCrossfadeReadPosition();
+        
+        if (crossfadeReadPosition != -1.0 && crossfadeReadPosition < 0.0)
+            return "the crossfade reads from " + juce::String(crossfadeReadPosition) + " after the riser switch at sample " + juce::String(i);
+    }
+    
+    if (riserLine.getNumBufferResizes() == 0)
+        return "the delay time changes never resized the buffers";
+    
+    return {};
+}
+
+juce::String RiserLineCheck::checkAlignmentOfShortRiser(int numChannels, double tempo, int numerator, size_t memoryLimit) const
+{
+    RiserLineBase::Params params;
+    params.delayTime = 4.0f;
+    params.riserLength = 7.0f;
+    params.tempo = tempo;
+    params.timeSignature.numerator = numerator;
+    params.timeSignature.denominator = 4;
+    params.hasPosition = true;
+    
+    RiserLine<float> riserLine(params.delayTime, params.riserLength);
+    riserLine.setMemoryLimit(memoryLimit);
+    riserLine.prepare(params.delayTime, params.riserLength, params.accelerateCap, params.feedback, params.tempo, settings.sampleRate, numChannels);
+    
+    const int blockSize = 256;
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::Random random(2010);
+
+//    the transport starts part way into a bar, so the first block has to move the pointers
+    const double quarterNotesPerSample = tempo / (60.0 * settings.sampleRate);
+    const double barLength = numerator;
+    double ppqPosition = 3.3;
+    
+    for (int samplesDone = 0; riserLine.getNumRiserSwitches() < 4; samplesDone += blockSize)
+    {
+        if (samplesDone > settings.sampleRate * 120.0)
+            return "the riser never switched 4 times";
+        
+        params.ppqPosition = ppqPosition;
+        params.ppqPositionOfLastBarStart = std::floor(ppqPosition / barLength) * barLength;
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+        
+        riserLine.processBlock(buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), numChannels, blockSize, params);
+        ppqPosition += blockSize * quarterNotesPerSample;
+    }
+    
+    if (memoryLimit > 0 && ! riserLine.isMemoryLimited())
+        return "the memory limit didn't cut the buffers short";
+    
+    if (riserLine.getNumAlignmentResets() > 1)
+        return "the riser pointers were moved " + juce::String((int) riserLine.getNumAlignmentResets()) + " times with the transport running steadily";
+    
+    return {};
+}
+
+juce::String RiserLineCheck::checkProcessorAlignment(int numChannels, int blockSize) const
+{
+    const int maxBlockSize = 2048;
+    
+    RiseUpAudioProcessor processor;
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+    
+    if (! processor.setBusesLayout(layout))
+        return "the processor doesn't take " + juce::String(numChannels) + " channels";
+    
+    RenderPlayHead playHead(120.0, settings.sampleRate);
+    processor.setPlayHead(&playHead);
+    processor.setRateAndBufferSizeDetails(settings.sampleRate, maxBlockSize);
+    processor.prepareToPlay(settings.sampleRate, maxBlockSize);
+    
+    juce::AudioBuffer<float> buffer(numChannels, maxBlockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Random random(2024);
+    
+//    long enough for the default riser to run several cycles
+    const int numSamples = (int) (settings.sampleRate * 10.0);
+    
+    for (int samplesDone = 0; samplesDone < numSamples;)
+    {
+        const int numBlockSamples = blockSize > 0 ? blockSize : 1 + random.nextInt(maxBlockSize);
+        buffer.setSize(numChannels, numBlockSamples, false, false, true);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numBlockSamples; ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+        
+        processor.processBlock(buffer, midiMessages);
+        playHead.advance(numBlockSamples);
+        samplesDone += numBlockSamples;
+    }
+    
+    const auto numResets = processor.getNumAlignmentResets();
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    
+    if (numResets > 0)
+        return "the riser pointers were moved " + juce::String((int) numResets) + " times with the transport running steadily";
+    
+    return {};
+}
+
+int RiserLineCheck::run(std::ostream& output) const
+{
+    int numFailed = 0;
+    
+    for (auto& check : createChecks())
+    {
+        for (auto numChannels : settings.channelCounts)
+        {
+            const auto name = check.name + " (" + juce::String(numChannels) + (numChannels == 1 ? " channel)" : " channels)");
+            const auto failure = check.run(numChannels);
+            
+            if (failure.isEmpty())
+            {
+                output << "PASS  " << name << std::endl;
+                continue;
+            }
+            
+            ++numFailed;
+            output << "FAIL  " << name << ": " << failure << std::endl;
+        }
+    }
+    
+    return numFailed;
+}
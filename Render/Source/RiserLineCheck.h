@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    RiserLineCheck.h
+    Created: 15 Apr 2024 10:27:53am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/RiserLine.h"
+#include "../../Source/PluginProcessor.h"
+#include "RenderPlayHead.h"
+
+// Runs RiserLine through the edge cases that have broken it before (pointers left out of range at a riser switch, buffer
+// resizes at awkward moments, host alignment of risers cut short or fed host blocks off the processor's chunk grid) and checks how it behaves rather than what it outputs, so unlike the golden files the checks
+// stay valid when the sound is meant to change. Each check renders noise under the conditions it's named after.
+class RiserLineCheck
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 44100.0;
+        juce::Array<int> channelCounts { 1, 2 };   // mono runs the read-head kernel path, more channels the SIMDRegister one
+    };
+    
+    explicit RiserLineCheck(const Settings& settings);
+    
+    // run every check for every channel count, write the report to 'output' and return the number that failed
+    int run(std::ostream& output) const;
+
+private:
+    // a check hands back what went wrong, or an empty string when it passed
+    struct Check
+    {
+        juce::String name;
+        std::function<juce::String (int numChannels)> run;
+    };
+    
+    juce::Array<Check> createChecks() const;
+    
+    // the riser switches on the last sample of a block and the next block changes the delay time
+    juce::String checkResizeAfterRiserSwitch(int numChannels) const;
+    
+    // a 2 bar riser cut short to fit the buffers (by the time signature at a slow tempo, or by 'memoryLimit') follows
+    // the host position through several cycles, and its pointers are moved once at the start and never again
+    juce::String checkAlignmentOfShortRiser(int numChannels, double tempo, int numerator, size_t memoryLimit) const;
+    
+    // the whole processor with the transport playing steadily, in host blocks of 'blockSize' samples (random sizes up to
+    // 2048 for 0) that start part way into its chunks, and its RiserLines never move their pointers to follow it
+    juce::String checkProcessorAlignment(int numChannels, int blockSize) const;
+    
+    Settings settings;
+};
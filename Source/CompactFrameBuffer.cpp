@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    CompactFrameBuffer.cpp
+    Created: 21 Mar 2024 11:26:58am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "CompactFrameBuffer.h"
+
+void CompactFrameBuffer::setSize(int newNumFrames, int newNumChannels)
+{
+    numFrames = juce::jmax(0, newNumFrames);
+    numChannels = juce::jmax(1, newNumChannels);
+    data.calloc((size_t) numFrames * (size_t) numChannels);
+}
+
+template <typename SampleType>
+void CompactFrameBuffer::writeFrame(int frame, const SampleType* samples) noexcept
+{
+    juce::int16* dest = data + (size_t) frame * (size_t) numChannels;
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        dest[channel] = toInteger((float) samples[channel]);
+}
+
+template <typename SampleType>
+void CompactFrameBuffer::readFrame(int frame, SampleType* samples) const noexcept
+{
+    const juce::int16* source = data + (size_t) frame * (size_t) numChannels;
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        samples[channel] = (SampleType) source[channel] * (SampleType) toFloat;
+}
+
+template <typename SampleType>
+void CompactFrameBuffer::write(int startFrame, const SampleType* samples, int numFramesToWrite) noexcept
+{
+    jassert(numChannels == 1 && startFrame >= 0 && startFrame + numFramesToWrite <= numFrames);
+    
+    juce::int16* dest = data + startFrame;
+    
+    for (int i = 0; i < numFramesToWrite; ++i)
+        dest[i] = toInteger((float) samples[i]);
+}
+
+juce::int16 CompactFrameBuffer::toInteger(float sample) noexcept
+{
+//    triangular dither from the difference of two uniform values, a step of the LCG each (1 LSB either way)
+    ditherState = ditherState * 1664525u + 1013904223u;
+    const float first = (float) (ditherState >> 8) * (1.0f / 16777216.0f);
+    ditherState = ditherState * 1664525u + 1013904223u;
+    const float second = (float) (ditherState >> 8) * (1.0f / 16777216.0f);
+    
+    const float scaled = sample * fromFloat + (first - second);
+
+//    clamped while still a float, converting an inf or anything past the range of an int is undefined (a NaN stores 0)
+    if (std::isnan(scaled))
+        return 0;
+    
+    return (juce::int16) juce::jlimit(-32767.0f, 32767.0f, std::floor(scaled + 0.5f));
+}
+
+template void CompactFrameBuffer::writeFrame(int, const float*) noexcept;
+template void CompactFrameBuffer::writeFrame(int, const double*) noexcept;
+template void CompactFrameBuffer::readFrame(int, float*) const noexcept;
+template void CompactFrameBuffer::readFrame(int, double*) const noexcept;
+template void CompactFrameBuffer::write(int, const float*, int) noexcept;
+template void CompactFrameBuffer::write(int, const double*, int) noexcept;
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    CompactFrameBuffer.h
+    Created: 21 Mar 2024 11:26:50am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A buffer of interleaved frames like FrameBuffer, but holding one 16-bit integer per channel instead of a padded
+// float lane (a quarter of the memory for stereo). Samples are written with TPDF dither and 'headroom' over full scale,
+// anything louder than that is clipped. The frames are read and written as float or double ('SampleType').
+class CompactFrameBuffer
+{
+public:
+    // allocate (and clear) room for 'newNumFrames' frames of 'newNumChannels' samples, never call this from the audio thread
+    void setSize(int newNumFrames, int newNumChannels);
+    
+    // convert the first 'numChannels' samples of 'samples' (a FrameBuffer frame may be padded wider) into 'frame'
+    template <typename SampleType>
+    void writeFrame(int frame, const SampleType* samples) noexcept;
+    
+    // convert 'frame' back into the first 'numChannels' samples of 'samples'
+    template <typename SampleType>
+    void readFrame(int frame, SampleType* samples) const noexcept;
+    
+    // convert 'numFramesToWrite' mono samples starting at 'startFrame'
+    template <typename SampleType>
+    void write(int startFrame, const SampleType* samples, int numFramesToWrite) noexcept;
+    
+    float getSample(int frame, int channel) const noexcept { return (float) data[(size_t) frame * (size_t) numChannels + (size_t) channel] * toFloat; }
+    
+    int getNumFrames() const noexcept { return numFrames; }
+    int getNumChannels() const noexcept { return numChannels; }
+    
+    size_t getSizeInBytes() const noexcept { return (size_t) numFrames * (size_t) numChannels * sizeof(juce::int16); }
+    
+    // the largest magnitude stored without clipping (6dB over full scale)
+    static constexpr float headroom = 2.0f;
+
+private:
+    juce::int16 toInteger(float sample) noexcept;
+    
+    static constexpr float toFloat = headroom / 32767.0f;
+    static constexpr float fromFloat = 32767.0f / headroom;
+    
+    juce::HeapBlock<juce::int16> data;
+    juce::uint32 ditherState = 1;
+    int numFrames = 0;
+    int numChannels = 1;
+};
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    EcoResampler.cpp
+    Created: 12 Apr 2024 2:41:09pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "EcoResampler.h"
+
+template <typename SampleType>
+void EcoResampler<SampleType>::prepare(int newFactor, int numChannels, int maxBlockSize)
+{
+    jassert(newFactor == 1 || newFactor == 2 || newFactor == maxFactor);
+    
+    factor = newFactor >= maxFactor ? maxFactor : juce::jmax(1, newFactor);
+    numStages = factor == maxFactor ? 2 : factor - 1;
+
+//    the ideal half-band response 1/2 sinc(d/2) at the odd distances d from the centre, under a Blackman window
+    const double pi = juce::MathConstants<double>::pi;
+    const double windowLength = 4.0 * numSideTaps;
+    double sum = 0.0;
+    std::array<double, numSideTaps> taps;
+    
+    for (int tap = 0; tap < numSideTaps; ++tap)
+    {
+        const double distance = 2 * tap + 1;
+        const double window = 0.42 + 0.5 * std::cos(2.0 * pi * distance / windowLength)
+                                   + 0.08 * std::cos(4.0 * pi * distance / windowLength);
+        
+        taps[(size_t) tap] = std::sin(0.5 * pi * distance) / (pi * distance) * window;
+        sum += taps[(size_t) tap];
+    }
+
+//    unity gain at DC, with the centre tap's 1/2
+    for (int tap = 0; tap < numSideTaps; ++tap)
+        sideTaps[(size_t) tap] = (SampleType) (taps[(size_t) tap] * 0.25 / sum);
+    
+    for (int stage = 0; stage < maxStages; ++stage)
+    {
+        const int stageChannels = stage < numStages ? numChannels : 0;
+        const int blockSize = maxBlockSize >> stage;
+        
+        stages[(size_t) stage].down.setSize(stageChannels, downHistory + blockSize);
+        stages[(size_t) stage].up.setSize(stageChannels, upHistory + blockSize / 2);
+    }
+    
+    halfRate.setSize(numStages > 1 ? numChannels : 0, maxBlockSize / 2);
+    reset();
+}
+
+template <typename SampleType>
+void EcoResampler<SampleType>::reset()
+{
+    for (auto& stage : stages)
+    {
+        stage.down.clear();
+        stage.up.clear();
+    }
+    
+    halfRate.clear();
+}
+
+template <typename SampleType>
+int EcoResampler<SampleType>::getLatencyInSamples() const noexcept
+{
+//    each stage delays by one sample less than its centre tap going down and its centre tap coming up, at its higher rate
+    const int stageLatency = 2 * (2 * numSideTaps - 1) - 1;
+    int latency = 0;
+    
+    for (int stage = 0; stage < numStages; ++stage)
+        latency += stageLatency << stage;
+    
+    return latency;
+}
+
+template <typename SampleType>
+void EcoResampler<SampleType>::decimate(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples)
+{
+    jassert(numSamples % factor == 0);
+    
+    if (numStages == 1)
+    {
+        decimateStage(stages[0], input, output, numChannels, numSamples);
+        return;
+    }
+    
+    decimateStage(stages[0], input, halfRate.getArrayOfWritePointers(), numChannels, numSamples);
+    decimateStage(stages[1], halfRate.getArrayOfReadPointers(), output, numChannels, numSamples / 2);
+}
+
+template <typename SampleType>
+void EcoResampler<SampleType>::interpolate(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples)
+{
+    jassert(numSamples % factor == 0);
+    
+    if (numStages == 1)
+    {
+        interpolateStage(stages[0], input, output, numChannels, numSamples / 2);
+        return;
+    }
+    
+    interpolateStage(stages[1], input, halfRate.getArrayOfWritePointers(), numChannels, numSamples / 4);
+    interpolateStage(stages[0], halfRate.getArrayOfReadPointers(), output, numChannels, numSamples / 2);
+}
+
+template <typename SampleType>
+void EcoResampler<SampleType>::decimateStage(Stage& stage, const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        SampleType* samples = stage.down.getWritePointer(channel);
+        std::copy(input[channel], input[channel] + numSamples, samples + downHistory);
+        
+        for (int i = 0; i < numSamples / 2; ++i)
+        {
+//            every output sample filters up to the second of its pair of input samples, centred 2 * numSideTaps - 1 before it
+            const SampleType* centre = samples + downHistory + 2 * i + 1 - (2 * numSideTaps - 1);
+            SampleType sum = (SampleType) 0.5 * centre[0];
+            
+            for (int tap = 0; tap < numSideTaps; ++tap)
+                sum += sideTaps[(size_t) tap] * (centre[2 * tap + 1] + centre[-2 * tap - 1]);
+            
+            output[channel][i] = sum;
+        }
+
+//        the end of the block becomes the history of the next one
+        std::copy(samples + numSamples, samples + numSamples + downHistory, samples);
+    }
+}
+
+template <typename SampleType>
+void EcoResampler<SampleType>::interpolateStage(Stage& stage, const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        SampleType* samples = stage.up.getWritePointer(channel);
+        std::copy(input[channel], input[channel] + numSamples, samples + upHistory);
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+//            of every pair of output samples the first falls halfway between two input samples and needs the odd taps,
+//            the second falls on the centre tap (twice 1/2, since zeros were stuffed between the input samples)
+            const SampleType* centre = samples + upHistory + i - (numSideTaps - 1);
+            SampleType sum = 0;
+            
+            for (int tap = 0; tap < numSideTaps; ++tap)
+                sum += sideTaps[(size_t) tap] * (centre[tap] + centre[-1 - tap]);
+            
+            output[channel][2 * i] = (SampleType) 2 * sum;
+            output[channel][2 * i + 1] = centre[0];
+        }
+        
+        std::copy(samples + numSamples, samples + numSamples + upHistory, samples);
+    }
+}
+
+template <typename SampleType>
+size_t EcoResampler<SampleType>::getSizeInBytes() const noexcept
+{
+    size_t numSamples = (size_t) halfRate.getNumChannels() * (size_t) halfRate.getNumSamples();
+    
+    for (auto& stage : stages)
+        numSamples += (size_t) stage.down.getNumChannels() * (size_t) stage.down.getNumSamples()
+                    + (size_t) stage.up.getNumChannels() * (size_t) stage.up.getNumSamples();
+    
+    return numSamples * sizeof(SampleType);
+}
+
+template class EcoResampler<float>;
+template class EcoResampler<double>;
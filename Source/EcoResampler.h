@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    EcoResampler.h
+    Created: 12 Apr 2024 2:41:09pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Takes the input of eco mode down to a half or a quarter of the sample rate for the RiserLines, and their wet signal back
+// up, through one half-band FIR stage each way for every halving. Every other tap of a half-band filter is zero apart
+// from the centre one (1/2), so a stage only works out its symmetric odd taps, once per sample at the lower rate:
+// 'numSideTaps' + 1 multiplies per sample going down, 'numSideTaps' per pair of samples coming up.
+// 'SampleType' is float or double, the same as the RiserLines it feeds.
+template <typename SampleType>
+class EcoResampler
+{
+public:
+    // 'newFactor' is 1 (nothing to resample), 2 or 4. Blocks are given in full rate samples, a multiple of the factor and
+    // no more than 'maxBlockSize'
+    void prepare(int newFactor, int numChannels, int maxBlockSize);
+    
+    // clear the filter histories
+    void reset();
+    
+    int getFactor() const noexcept { return factor; }
+    
+    // the delay of the way down and back up together, in full rate samples
+    int getLatencyInSamples() const noexcept;
+    
+    // 'numSamples' full rate samples of every channel down to numSamples / factor in 'output'
+    void decimate(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+    
+    // numSamples / factor samples of every channel up to 'numSamples' full rate samples in 'output'
+    void interpolate(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+    
+    // the bytes held by the filter histories
+    size_t getSizeInBytes() const noexcept;
+    
+    // the nonzero taps on either side of the centre tap, 4 * numSideTaps - 1 taps in all
+    static constexpr int numSideTaps = 12;
+    
+    static constexpr int maxFactor = 4;
+
+private:
+    static constexpr int maxStages = 2;
+
+//    the samples before the block each filter reaches back to, at the rate going into it
+    static constexpr int downHistory = 4 * numSideTaps - 3;
+    static constexpr int upHistory = 2 * numSideTaps - 1;
+
+//    a stage halves the rate on the way down and doubles it on the way up. 'down' and 'up' hold every channel's history
+//    followed by the block being filtered
+    struct Stage
+    {
+        juce::AudioBuffer<SampleType> down;
+        juce::AudioBuffer<SampleType> up;
+    };
+    
+    void decimateStage(Stage& stage, const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+    void interpolateStage(Stage& stage, const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+
+//    the odd taps from the centre out, windowed so the ones on both sides add up to 1/2
+    std::array<SampleType, numSideTaps> sideTaps {};
+    
+    std::array<Stage, maxStages> stages;
+    int numStages = 0;
+    int factor = 1;
+
+//    the half rate signal between the two stages at a quarter of the rate
+    juce::AudioBuffer<SampleType> halfRate;
+};
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    FrameBuffer.cpp
+    Created: 3 Feb 2024 2:41:20pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "FrameBuffer.h"
+
+template <typename SampleType>
+void FrameBuffer<SampleType>::setSize(int newNumFrames, int newNumLanes)
+{
+    numFrames = juce::jmax(0, newNumFrames);
+    numLanes = juce::jmax(1, newNumLanes);
+
+//    allocate one extra register so the start of the data can be moved up to the next aligned address
+    const auto numSamples = (size_t) numFrames * (size_t) numLanes;
+    memory.calloc(numSamples * sizeof(SampleType) + SIMDRegister::SIMDRegisterSize);
+    data = SIMDRegister::getNextSIMDAlignedPtr(reinterpret_cast<SampleType*>(memory.get()));
+}
+
+template <typename SampleType>
+void FrameBuffer<SampleType>::clear()
+{
+    clear(0, numFrames);
+}
+
+template <typename SampleType>
+void FrameBuffer<SampleType>::clear(int startFrame, int numFramesToClear)
+{
+    jassert(startFrame >= 0 && startFrame + numFramesToClear <= numFrames);
+    
+    if (numFramesToClear > 0)
+        juce::FloatVectorOperations::clear(getFrame(startFrame), numFramesToClear * numLanes);
+}
+
+template <typename SampleType>
+void FrameBuffer<SampleType>::applyGainRamp(int startFrame, int numFramesToRamp, float startGain, float endGain)
+{
+    jassert(startFrame >= 0 && startFrame + numFramesToRamp <= numFrames);
+    
+    if (numFramesToRamp <= 0)
+        return;
+    
+    const float increment = (endGain - startGain) / (float) numFramesToRamp;
+    
+    for (int i = 0; i < numFramesToRamp; ++i)
+    {
+        SampleType* frame = getFrame(startFrame + i);
+        
+        for (int lane = 0; lane < numLanes; ++lane)
+            frame[lane] *= startGain;
+        
+        startGain += increment;
+    }
+}
+
+template <typename SampleType>
+int FrameBuffer<SampleType>::getNumLanesFor(int numChannels)
+{
+    if (numChannels <= 1)
+        return 1;
+    
+    const int width = (int) SIMDRegister::SIMDNumElements;
+    return (numChannels + width - 1) / width * width;
+}
+
+template class FrameBuffer<float>;
+template class FrameBuffer<double>;
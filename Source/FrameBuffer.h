@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    FrameBuffer.h
+    Created: 3 Feb 2024 2:41:12pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A buffer of interleaved frames, each holding one sample per lane (one lane per channel, padded to the SIMD width).
+// The storage is aligned so every group of lanes in a frame can be loaded straight into a juce::dsp::SIMDRegister.
+// 'SampleType' is float or double, a register holds half as many lanes of double.
+template <typename SampleType>
+class FrameBuffer
+{
+public:
+    using SIMDRegister = juce::dsp::SIMDRegister<SampleType>;
+    
+    // allocate (and clear) room for 'newNumFrames' frames of 'newNumLanes' samples, never call this from the audio thread
+    void setSize(int newNumFrames, int newNumLanes);
+    
+    void clear();
+    void clear(int startFrame, int numFramesToClear);
+    
+    // multiply every lane of the frames by a gain ramping linearly from 'startGain' to 'endGain'
+    void applyGainRamp(int startFrame, int numFramesToRamp, float startGain, float endGain);
+    
+    SampleType* getFrame(int frame) noexcept { return data + (size_t) frame * (size_t) numLanes; }
+    const SampleType* getFrame(int frame) const noexcept { return data + (size_t) frame * (size_t) numLanes; }
+    
+    int getNumFrames() const noexcept { return numFrames; }
+    int getNumLanes() const noexcept { return numLanes; }
+    
+    // the bytes allocated for the frames, including the alignment padding
+    size_t getSizeInBytes() const noexcept { return memory == nullptr ? 0 : (size_t) numFrames * (size_t) numLanes * sizeof(SampleType) + SIMDRegister::SIMDRegisterSize; }
+    
+    // mono stays a single scalar lane, anything wider is padded up to a whole number of SIMD registers
+    static int getNumLanesFor(int numChannels);
+
+private:
+    juce::HeapBlock<char> memory;
+    SampleType* data = nullptr;
+    int numFrames = 0;
+    int numLanes = 1;
+};
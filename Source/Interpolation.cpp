@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    Interpolation.cpp
+    Created: 18 Feb 2024 11:02:44am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "Interpolation.h"
+
+namespace Interpolation
+{
+
+SincTable::SincTable()
+{
+    coefficients.resize((size_t) (numBands * (numPhases + 1) * sincTaps));
+    
+    const double pi = juce::MathConstants<double>::pi;
+    
+    for (int band = 0; band < numBands; ++band)
+    {
+//        a little under the Nyquist frequency of the sped-up read, so the short kernel has room for its transition band
+        const double cutoff = 0.9 / (band + 1);
+        
+        for (int phase = 0; phase <= numPhases; ++phase)
+        {
+            const double fraction = (double) phase / numPhases;
+            float* weights = coefficients.data() + (size_t) (band * (numPhases + 1) + phase) * sincTaps;
+            double sum = 0.0;
+            
+            for (int tap = 0; tap < sincTaps; ++tap)
+            {
+                const double distance = tap + getFirstTapOffset(sincTaps) - fraction;
+                const double x = pi * cutoff * distance;
+                const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+                const double window = 0.42 + 0.5 * std::cos(2.0 * pi * distance / sincTaps)
+                                           + 0.08 * std::cos(4.0 * pi * distance / sincTaps);
+                
+                weights[tap] = (float) (sinc * window);
+                sum += weights[tap];
+            }
+
+//            unity gain at DC for every phase
+            for (int tap = 0; tap < sincTaps; ++tap)
+                weights[tap] = (float) (weights[tap] / sum);
+        }
+    }
+}
+
+}
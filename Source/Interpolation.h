@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    Interpolation.h
+    Created: 18 Feb 2024 11:02:36am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The fractional delay reads of the RiserLine, as a set of taps around the read position and a weight for each tap.
+// Every quality costs the same fixed number of multiply-adds per sample, so the gap between them is predictable.
+namespace Interpolation
+{
+    enum class Quality
+    {
+        linear = 0,     // 2 taps
+        hermite,        // 4 taps, 3rd order Hermite (Catmull-Rom)
+        sinc            // 8 taps, polyphase windowed-sinc
+    };
+    
+    constexpr int linearTaps = 2;
+    constexpr int hermiteTaps = 4;
+    constexpr int sincTaps = 8;
+    
+    // the offset of the first tap from floor(read position), the rest follow one sample apart
+    constexpr int getFirstTapOffset(int numTaps) { return 1 - numTaps / 2; }
+    
+    // 'fraction' is the read position minus floor(read position), the weights are float or double
+    template <typename SampleType>
+    inline void getLinearWeights(SampleType fraction, SampleType* weights) noexcept
+    {
+        weights[0] = (SampleType) 1 - fraction;
+        weights[1] = fraction;
+    }
+    
+    template <typename SampleType>
+    inline void getHermiteWeights(SampleType fraction, SampleType* weights) noexcept
+    {
+        const SampleType a = fraction;
+        const SampleType a2 = a * a;
+        const SampleType a3 = a2 * a;
+        
+        weights[0] = -0.5f * a3 + a2 - 0.5f * a;
+        weights[1] = 1.5f * a3 - 2.5f * a2 + 1.0f;
+        weights[2] = -1.5f * a3 + 2.0f * a2 + 0.5f * a;
+        weights[3] = 0.5f * a3 - 0.5f * a2;
+    }
+    
+    // Blackman-windowed sinc coefficients for 'sincPhases' fractional positions, one table per cutoff band.
+    // The read head speeds up to 4x, so the cutoff drops with the read speed to keep the pitched-up riser from aliasing.
+    // Built once per process and shared (read-only) by every RiserLine through SharedTables.
+    class SincTable
+    {
+    public:
+        static constexpr int numPhases = 256;
+        static constexpr int numBands = 4;
+        
+        SincTable();
+        
+        // the weights for the phase closest to 'fraction', band 'n' is for read speeds around n + 1
+        const float* getWeights(int band, float fraction) const noexcept
+        {
+            const int phase = (int) (fraction * numPhases + 0.5f);
+            return coefficients.data() + (size_t) (band * (numPhases + 1) + phase) * sincTaps;
+        }
+        
+        static int getBandForSpeed(double speed) noexcept
+        {
+            return juce::jlimit(0, numBands - 1, (int) (speed + 0.5) - 1);
+        }
+    
+        size_t getSizeInBytes() const noexcept { return coefficients.size() * sizeof(float); }
+    
+    private:
+        std::vector<float> coefficients;
+    };
+}
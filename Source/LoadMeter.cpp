@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    LoadMeter.cpp
+    Created: 4 Apr 2024 9:15:47pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "LoadMeter.h"
+
+void LoadMeter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    clear();
+}
+
+void LoadMeter::clear() noexcept
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    
+    for (auto& count : eventCounts)
+        count.store(0, std::memory_order_relaxed);
+    
+    numBlocks.store(0, std::memory_order_relaxed);
+    totalLoad.store(0.0, std::memory_order_relaxed);
+    maxLoad.store(0.0, std::memory_order_relaxed);
+    
+    slowestSequence.fetch_add(1, std::memory_order_acq_rel);
+    slowestNumSamples.store(0, std::memory_order_relaxed);
+    slowestSequence.fetch_add(1, std::memory_order_release);
+}
+
+int LoadMeter::getBucket(double load) noexcept
+{
+    if (! (load >= minLoad))
+        return 0;
+    
+    return juce::jmin(numBuckets - 1, 1 + (int) (std::log2(load / minLoad) * bucketsPerOctave));
+}
+
+double LoadMeter::getBucketStart(int bucket) noexcept
+{
+    return bucket <= 0 ? 0.0 : minLoad * std::exp2((double) (bucket - 1) / bucketsPerOctave);
+}
+
+void LoadMeter::addBlock(juce::int64 startTicks, int numSamples, const EventCounts& events, const PresetBank::Values& values) noexcept
+{
+    const auto endTicks = getTicks();
+    
+    if (resetRequested.exchange(false))
+        clear();
+    
+    if (numSamples <= 0)
+        return;
+    
+    const double seconds = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks);
+    const double load = seconds * sampleRate / numSamples;
+
+//    only this thread writes, so a load and a store do for every update
+    auto& bucket = buckets[(size_t) getBucket(load)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    
+    for (size_t i = 0; i < events.size(); ++i)
+        if (events[i] > 0)
+            eventCounts[i].store(eventCounts[i].load(std::memory_order_relaxed) + events[i], std::memory_order_relaxed);
+    
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalLoad.store(totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+    
+    if (load <= maxLoad.load(std::memory_order_relaxed))
+        return;
+    
+    maxLoad.store(load, std::memory_order_relaxed);
+    
+    slowestSequence.fetch_add(1, std::memory_order_acq_rel);
+    slowestNumSamples.store(numSamples, std::memory_order_relaxed);
+    
+    for (size_t i = 0; i < events.size(); ++i)
+        slowestEvents[i].store(events[i], std::memory_order_relaxed);
+    
+    for (size_t i = 0; i < values.size(); ++i)
+        slowestValues[i].store(values[i], std::memory_order_relaxed);
+    
+    slowestSequence.fetch_add(1, std::memory_order_release);
+}
+
+LoadMeter::Statistics LoadMeter::getStatistics() const
+{
+    Statistics statistics;
+    juce::uint64 total = 0;
+    
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        statistics.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        total += statistics.buckets[i];
+    }
+    
+    for (size_t i = 0; i < eventCounts.size(); ++i)
+        statistics.eventCounts[i] = eventCounts[i].load(std::memory_order_relaxed);
+    
+    statistics.numBlocks = total;
+    statistics.maxLoad = maxLoad.load(std::memory_order_relaxed);
+    statistics.meanLoad = total > 0 ? totalLoad.load(std::memory_order_relaxed) / (double) numBlocks.load(std::memory_order_relaxed) : 0.0;
+
+//    the percentiles are the upper edge of the bucket they fall in, never more than the slowest block
+    auto getPercentile = [&] (double fraction)
+    {
+        const auto target = (juce::uint64) std::ceil(fraction * (double) total);
+        juce::uint64 count = 0;
+        
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            count += statistics.buckets[(size_t) i];
+            
+            if (count >= target)
+                return juce::jmin(getBucketStart(i + 1), statistics.maxLoad);
+        }
+        
+        return statistics.maxLoad;
+    };
+    
+    if (total > 0)
+    {
+        statistics.p50 = getPercentile(0.5);
+        statistics.p99 = getPercentile(0.99);
+    }
+
+//    copy the slowest block again if it was being written meanwhile
+    for (;;)
+    {
+        const auto sequence = slowestSequence.load(std::memory_order_acquire);
+        
+        if ((sequence & 1) == 0)
+        {
+            statistics.slowestNumSamples = slowestNumSamples.load(std::memory_order_relaxed);
+            
+            for (size_t i = 0; i < slowestEvents.size(); ++i)
+                statistics.slowestEvents[i] = slowestEvents[i].load(std::memory_order_relaxed);
+            
+            for (size_t i = 0; i < slowestValues.size(); ++i)
+                statistics.slowestValues[i] = slowestValues[i].load(std::memory_order_relaxed);
+            
+            std::atomic_thread_fence(std::memory_order_acquire);
+            
+            if (slowestSequence.load(std::memory_order_relaxed) == sequence)
+                break;
+        }
+        
+        std::this_thread::yield();
+    }
+    
+    return statistics;
+}
+
+const char* LoadMeter::getEventName(Event event) noexcept
+{
+    switch (event)
+    {
+        case riserSwitch:         return "riser switches";
+        case bufferResize:        return "buffer resizes";
+        case programChange:       return "program changes";
+        case riserLinesRebuilt:   return "riser line rebuilds";
+        case numEvents:
+        default:                  return "";
+    }
+}
+
+juce::String LoadMeter::createReport() const
+{
+    const auto statistics = getStatistics();
+    auto percent = [] (double load) { return juce::String(load * 100.0, 2) + "%"; };
+    
+    juce::String report;
+    report << "blocks: " << (juce::int64) statistics.numBlocks << juce::newLine
+           << "DSP load: mean " << percent(statistics.meanLoad) << ", p50 " << percent(statistics.p50)
+           << ", p99 " << percent(statistics.p99) << ", max " << percent(statistics.maxLoad) << juce::newLine;
+    
+    for (int i = 0; i < numEvents; ++i)
+        report << getEventName((Event) i) << ": " << (juce::int64) statistics.eventCounts[(size_t) i] << juce::newLine;
+    
+    report << "slowest block: " << statistics.slowestNumSamples << " samples";
+    
+    for (int i = 0; i < numEvents; ++i)
+        if (statistics.slowestEvents[(size_t) i] > 0)
+            report << ", " << (int) statistics.slowestEvents[(size_t) i] << " " << getEventName((Event) i);
+    
+    report << juce::newLine << "slowest block parameters:";
+    
+    for (int i = 0; i < PresetBank::numParameters; ++i)
+        report << " " << PresetBank::getParameterName((PresetBank::Parameter) i) << "=" << juce::String(statistics.slowestValues[(size_t) i], 2);
+    
+    return report << juce::newLine;
+}
+
+juce::String LoadMeter::createCSV() const
+{
+    const auto statistics = getStatistics();
+    
+    juce::String csv;
+    csv << "blocks,mean,p50,p99,max";
+    
+    for (int i = 0; i < numEvents; ++i)
+        csv << "," << juce::String(getEventName((Event) i)).replaceCharacter(' ', '_');
+    
+    csv << ",slowest_samples";
+    
+    for (int i = 0; i < numEvents; ++i)
+        csv << ",slowest_" << juce::String(getEventName((Event) i)).replaceCharacter(' ', '_');
+    
+    for (int i = 0; i < PresetBank::numParameters; ++i)
+        csv << ",slowest_" << PresetBank::getParameterName((PresetBank::Parameter) i);
+    
+    csv << juce::newLine << (juce::int64) statistics.numBlocks << "," << statistics.meanLoad << "," << statistics.p50
+        << "," << statistics.p99 << "," << statistics.maxLoad;
+    
+    for (auto count : statistics.eventCounts)
+        csv << "," << (juce::int64) count;
+    
+    csv << "," << statistics.slowestNumSamples;
+    
+    for (auto count : statistics.slowestEvents)
+        csv << "," << (int) count;
+    
+    for (auto value : statistics.slowestValues)
+        csv << "," << value;
+    
+    csv << juce::newLine << juce::newLine << "bucket_start,blocks" << juce::newLine;
+    
+    for (int i = 0; i < numBuckets; ++i)
+        csv << getBucketStart(i) << "," << (juce::int64) statistics.buckets[(size_t) i] << juce::newLine;
+    
+    return csv;
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+    Created: 4 Apr 2024 9:15:33pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PresetBank.h"
+
+// Times every processBlock() against how long the block lasts (its DSP load, 1 being the whole block) and keeps a histogram
+// of the loads, with counts of the expensive events that tend to come with slow blocks and the settings of the slowest block
+// so far. The audio thread is the only one writing, with plain atomic stores, so it's never held up by the editor
+// or an export reading at the same time.
+class LoadMeter
+{
+public:
+    enum Event
+    {
+        riserSwitch = 0,        // a riser cycle finished and the ring halves swapped
+        bufferResize,           // the delay or riser buffer size changed
+        programChange,          // a program change switched the settings
+        riserLinesRebuilt,      // the RiserLines were rebuilt (stereo link or memory settings)
+        numEvents
+    };
+    
+    using EventCounts = std::array<juce::uint32, numEvents>;
+    
+    // the buckets start at 'minLoad' and get 'bucketsPerOctave' buckets for every doubling of the load, everything
+    // below 'minLoad' goes in the first one and everything above the range in the last one
+    static constexpr int numBuckets = 80;
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr double minLoad = 1.0e-4;
+    
+    void prepare(double sampleRate);
+    
+    // the audio thread's clock, read at the start of the block
+    static juce::int64 getTicks() noexcept { return juce::Time::getHighResolutionTicks(); }
+    
+    // record a block of 'numSamples' that started at 'startTicks', with the events that happened in it and the
+    // parameter values it ran with (audio thread only)
+    void addBlock(juce::int64 startTicks, int numSamples, const EventCounts& events, const PresetBank::Values& values) noexcept;
+    
+    // clear everything, from any thread (the audio thread clears it at the start of its next block)
+    void reset() noexcept { resetRequested = true; }
+    
+    struct Statistics
+    {
+        juce::uint64 numBlocks = 0;
+        double meanLoad = 0.0;
+        double p50 = 0.0;   // the loads half and 99% of the blocks stay under (to the upper edge of their bucket)
+        double p99 = 0.0;
+        double maxLoad = 0.0;
+        std::array<juce::uint64, numEvents> eventCounts {};
+        
+        // the slowest block
+        int slowestNumSamples = 0;
+        EventCounts slowestEvents {};
+        PresetBank::Values slowestValues {};
+        
+        std::array<juce::uint64, numBuckets> buckets {};
+    };
+    
+    Statistics getStatistics() const;
+    
+    // the lower edge of a histogram bucket
+    static double getBucketStart(int bucket) noexcept;
+    
+    static const char* getEventName(Event event) noexcept;
+    
+    // the statistics as a readable report or as CSV (a summary row, then a row for every bucket)
+    juce::String createReport() const;
+    juce::String createCSV() const;
+
+private:
+    static int getBucket(double load) noexcept;
+    
+    double sampleRate = 44100.0;
+
+//    written by the audio thread only
+    std::array<std::atomic<juce::uint64>, numBuckets> buckets {};
+    std::array<std::atomic<juce::uint64>, numEvents> eventCounts {};
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<double> totalLoad { 0.0 };
+    std::atomic<double> maxLoad { 0.0 };
+
+//    the slowest block, guarded by a sequence count that is odd while it's being written: the reader copies it again
+//    if the count changed underneath it, the writer never waits
+    std::atomic<juce::uint32> slowestSequence { 0 };
+    std::atomic<int> slowestNumSamples { 0 };
+    std::array<std::atomic<juce::uint32>, numEvents> slowestEvents {};
+    std::array<std::atomic<float>, PresetBank::numParameters> slowestValues {};
+    
+    std::atomic<bool> resetRequested { false };
+    void clear() noexcept;
+    
+    JUCE_DECLARE_NON_COPYABLE (LoadMeter)
+};
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    ParameterSmoother.cpp
+    Created: 12 Mar 2024 11:18:11am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "ParameterSmoother.h"
+
+void ParameterSmoother::reset(double sampleRate, double rampLengthInSeconds)
+{
+    rampLength = juce::jmax(1, (int) std::floor(rampLengthInSeconds * sampleRate));
+    setCurrentAndTargetValue(targetValue);
+}
+
+void ParameterSmoother::setCurrentAndTargetValue(float newValue)
+{
+    currentValue = targetValue = newValue;
+    countdown = 0;
+}
+
+void ParameterSmoother::setTargetValue(float newTarget)
+{
+    if (newTarget == targetValue)
+        return;
+    
+    targetValue = newTarget;
+    countdown = rampLength;
+    step = (targetValue - currentValue) / (float) rampLength;
+}
+
+const float* ParameterSmoother::getNextValues(float* ramp, int numSamples) noexcept
+{
+    if (countdown == 0)
+        return nullptr;
+    
+    const int numRampSamples = juce::jmin(numSamples, countdown);
+    const float start = currentValue;
+
+//    computed from the start of the run rather than accumulated, so there's no dependency between samples
+    for (int i = 0; i < numRampSamples; ++i)
+        ramp[i] = start + step * (float) (i + 1);
+    
+    countdown -= numRampSamples;
+    
+    if (countdown == 0)
+    {
+        ramp[numRampSamples - 1] = targetValue;
+        juce::FloatVectorOperations::fill(ramp + numRampSamples, targetValue, numSamples - numRampSamples);
+        currentValue = targetValue;
+    }
+    else
+    {
+        currentValue = ramp[numRampSamples - 1];
+    }
+    
+    return ramp;
+}
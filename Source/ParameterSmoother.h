@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    ParameterSmoother.h
+    Created: 12 Mar 2024 11:18:03am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Ramps a parameter linearly to every new value over a fixed time so automation doesn't zipper.
+// Unlike juce::SmoothedValue it hands out a whole run of values at once, filled by a loop the compiler can vectorise.
+class ParameterSmoother
+{
+public:
+    // set the ramp time, a ramp in progress jumps to its target
+    void reset(double sampleRate, double rampLengthInSeconds);
+    
+    void setCurrentAndTargetValue(float newValue);
+    
+    // start a ramp from the current value (does nothing if 'newTarget' is already the target)
+    void setTargetValue(float newTarget);
+    
+    float getCurrentValue() const noexcept { return currentValue; }
+    float getTargetValue() const noexcept { return targetValue; }
+    bool isSmoothing() const noexcept { return countdown > 0; }
+    
+    // write the next 'numSamples' values into 'ramp' and return it, or return nullptr when the value holds still
+    // at getCurrentValue() for all of them
+    const float* getNextValues(float* ramp, int numSamples) noexcept;
+
+private:
+    float currentValue = 0.0f;
+    float targetValue = 0.0f;
+    float step = 0.0f;
+    int countdown = 0;
+    int rampLength = 1;
+};
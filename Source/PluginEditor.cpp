@@ -1,205 +1,319 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-#include "RiserLine.h"
-
-//==============================================================================
-RiseUpAudioProcessorEditor::RiseUpAudioProcessorEditor (RiseUpAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
-{
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-    
-    setSize (400, 300);
-    
-    delayTimeSlider.setSliderStyle (juce::Slider::RotaryVerticalDrag);
-    delayTimeSlider.setTextBoxStyle (juce::Slider::TextBoxBelow, true, 80, 20);
-    delayTimeSlider.setNormalisableRange(juce::NormalisableRange<double>(1.0, 5.0, 1.0));
-    delayTimeSlider.setValue (audioProcessor.getDelayTime());
-    delayTimeSlider.addListener (this);
-//    addAndMakeVisible (delayTimeSlider);
-    delayTimeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.getAPVTS(), "delayTime", delayTimeSlider);
-
-    feedbackSlider.setSliderStyle (juce::Slider::RotaryVerticalDrag);
-    feedbackSlider.setTextBoxStyle (juce::Slider::TextBoxBelow, true, 80, 20);
-    feedbackSlider.setNormalisableRange(juce::NormalisableRange<double>(0.0, 1.0, 0.01));
-    feedbackSlider.setValue (audioProcessor.getFeedback());
-    feedbackSlider.addListener (this);
-    addAndMakeVisible (feedbackSlider);
-    feedbackAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.getAPVTS(), "feedback", feedbackSlider);
-    
-    wetDrySlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    wetDrySlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
-    wetDrySlider.setNormalisableRange(juce::NormalisableRange<double>(0.0, 1.0, 0.01));
-    wetDrySlider.setValue(audioProcessor.getWetDryRatio());
-    wetDrySlider.addListener(this);
-    addAndMakeVisible(wetDrySlider);
-    wetDryAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.getAPVTS(), "wetDryRatio", wetDrySlider);
-    
-    riserLengthSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    riserLengthSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 80, 20);
-    riserLengthSlider.setNormalisableRange(juce::NormalisableRange<double>(3.0, 7.0, 1.0));
-    riserLengthSlider.setValue(audioProcessor.getRiserLength());
-    riserLengthSlider.addListener(this);
-    addAndMakeVisible(riserLengthSlider);
-    riserLengthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.getAPVTS(), "riserLength", riserLengthSlider);
-    
-    accelerateCapSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    accelerateCapSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
-    accelerateCapSlider.setNormalisableRange(juce::NormalisableRange<double>(1.1, 4.0, 0.1));
-    accelerateCapSlider.setValue(audioProcessor.getAccelerateCap());
-    accelerateCapSlider.addListener(this);
-    addAndMakeVisible(accelerateCapSlider);
-    accelerateCapAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.getAPVTS(), "accelerateCap", accelerateCapSlider);
-
-//    addAndMakeVisible(delayTimeLabel);
-    delayTimeLabel.setText("Delay Time", juce::dontSendNotification);
-//    delayTimeLabel.attachToComponent(&delayTimeSlider, false);
-
-    addAndMakeVisible(feedbackLabel);
-    feedbackLabel.setText("Feedback", juce::dontSendNotification);
-//    feedbackLabel.attachToComponent(&feedbackSlider, false);
-
-    addAndMakeVisible(wetDryLabel);
-    wetDryLabel.setText("Wet/Dry", juce::dontSendNotification);
-//    wetDryLabel.attachToComponent(&wetDrySlider, false);
-    
-    addAndMakeVisible(riserLengthLabel);
-    riserLengthLabel.setText("Riser Length", juce::dontSendNotification);
-//    riserLengthLabel.attachToComponent(&riserLengthSlider, false);
-    
-    addAndMakeVisible(accelerateCapLabel);
-    accelerateCapLabel.setText("Accelerate Cap", juce::dontSendNotification);
-//    accelerateCapLabel.attachToComponent(&accelerateCapSlider, false);
-    
-    addAndMakeVisible(riserNoteLabel);
-    riserNoteLabel.setText("1/4", juce::dontSendNotification);
-    
-    addAndMakeVisible(noteLabel);
-    noteLabel.setText("Note", juce::dontSendNotification);
-    
-}
-
-RiseUpAudioProcessorEditor::~RiseUpAudioProcessorEditor()
-{
-}
-
-//==============================================================================
-void RiseUpAudioProcessorEditor::paint (juce::Graphics& g)
-{
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-//    g.setColour (juce::Colours::white);
-//    g.setFont (15.0f);
-    
-    juce::Image myImage = juce::ImageCache::getFromMemory(BinaryData::RiseUp_BG_png, BinaryData::RiseUp_BG_pngSize);
-    
-    g.drawImage(myImage, getLocalBounds().toFloat());
-
-//    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
-}
-
-void RiseUpAudioProcessorEditor::resized()
-{
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
-    
-    int sliderWidth = 100;
-    int sliderHeight = 100;
-    int labelHeight = 20;
-    
-    delayTimeSlider.setBounds(20, 20, sliderWidth, sliderHeight);
-//    delayTimeLabel.setBounds(25, 20 + sliderHeight, sliderWidth, labelHeight);
-
-    feedbackSlider.setBounds(25, 190, sliderWidth, sliderHeight);
-    feedbackLabel.setBounds(40, 175, sliderWidth, labelHeight);
-
-    wetDrySlider.setBounds(285, 190, sliderWidth, sliderHeight);
-    wetDryLabel.setBounds(305, 175, sliderWidth, labelHeight);
-    
-    riserLengthSlider.setBounds(155, 110, 85, 85);
-    riserLengthLabel.setBounds(155, 90, 85, labelHeight);
-    
-    accelerateCapSlider.setBounds(285, 20, sliderWidth, sliderHeight);
-    accelerateCapLabel.setBounds(285, 5, sliderWidth, labelHeight);
-    
-    riserNoteLabel.setBounds(riserLengthSlider.getX()+23, riserLengthSlider.getY() + 30, 40, 10);
-    riserNoteLabel.setJustificationType(juce::Justification::centred);
-    noteLabel.setBounds(riserLengthSlider.getX()+23, riserLengthSlider.getY() + 45, 40, 10);
-    
-    riserLengthSlider.toFront(true);
-}
-
-void RiseUpAudioProcessorEditor::sliderValueChanged (juce::Slider* slider)
-{
-    // Handle slider value changes and update processor parameters
-    if (slider == &delayTimeSlider)
-    {
-        audioProcessor.setDelayTime(static_cast<float>(delayTimeSlider.getValue()));
-        riserLengthSlider.setValue(delayTimeSlider.getValue()+2.0);
-        audioProcessor.setRiserLength(static_cast<float>(riserLengthSlider.getValue()));
-    }
-    else if (slider == &feedbackSlider)
-    {
-        audioProcessor.setFeedback(static_cast<float>(feedbackSlider.getValue()));
-    }
-    else if (slider == &wetDrySlider)
-    {
-        audioProcessor.setWetDryRatio(static_cast<float>(wetDrySlider.getValue()));
-    }
-    else if (slider == &riserLengthSlider)
-    {
-        audioProcessor.setRiserLength(static_cast<float>(riserLengthSlider.getValue()));
-        delayTimeSlider.setValue(riserLengthSlider.getValue()-2.0);
-        audioProcessor.setDelayTime(static_cast<float>(delayTimeSlider.getValue()));
-        setNoteWithLength(static_cast<float>(riserLengthSlider.getValue()));
-    }
-    else if (slider == &accelerateCapSlider)
-    {
-        audioProcessor.setAccelerateCap(static_cast<float>(accelerateCapSlider.getValue()));
-    }
-    
-}
-
-void RiseUpAudioProcessorEditor::setNoteWithLength(float newRiserLength){
-    switch ((int)newRiserLength) {
-        case 1:
-            riserNoteLabel.setText("1/32", juce::dontSendNotification); // 1/32 note
-            break;
-        case 2:
-            riserNoteLabel.setText("1/16", juce::dontSendNotification); // 1/16 note
-            break;
-        case 3:
-            riserNoteLabel.setText("1/8", juce::dontSendNotification); // 1/8 note
-            break;
-        case 4:
-            riserNoteLabel.setText("1/4", juce::dontSendNotification); // 1/4 note
-            break;
-        case 5:
-            riserNoteLabel.setText("1/2", juce::dontSendNotification); // 1/2 note
-            break;
-        case 6:
-            riserNoteLabel.setText("1", juce::dontSendNotification);// 1 bar
-            break;
-        case 7:
-            riserNoteLabel.setText("2", juce::dontSendNotification); // 2 bard
-            break;
-            
-        default:
-            riserNoteLabel.setText("1/4", juce::dontSendNotification);
-            break;
-    }
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "RiserLine.h"
+
+//==============================================================================
+RiseUpAudioProcessorEditor::RiseUpAudioProcessorEditor (RiseUpAudioProcessor& p)
+    : AudioProcessorEditor (&p), audioProcessor (p), riserVisualiser (p.getTelemetry())
+{
+    // Make sure that before the constructor has finished, you've set the
+    // editor's size to whatever you need it to be.
+    
+    setSize (400, 300);
+    
+//    paint() covers every pixel, so nothing behind the editor is repainted along with it
+    setOpaque(true);
+    backgroundImage = juce::ImageCache::getFromMemory(BinaryData::RiseUp_BG_png, BinaryData::RiseUp_BG_pngSize);
+    
+    delayTimeSlider.setSliderStyle (juce::Slider::RotaryVerticalDrag);
+    delayTimeSlider.setTextBoxStyle (juce::Slider::TextBoxBelow, true, 80, 20);
+    delayTimeSlider.setNormalisableRange(juce::NormalisableRange<double>(1.0, 5.0, 1.0));
+    delayTimeSlider.setValue (audioProcessor.getDelayTime());
+    delayTimeSlider.addListener (this);
+//    addAndMakeVisible (delayTimeSlider);
+    delayTimeAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("delayTime"), delayTimeSlider);
+
+    feedbackSlider.setSliderStyle (juce::Slider::RotaryVerticalDrag);
+    feedbackSlider.setTextBoxStyle (juce::Slider::TextBoxBelow, true, 80, 20);
+    feedbackSlider.setNormalisableRange(juce::NormalisableRange<double>(0.0, 1.0, 0.01));
+    feedbackSlider.setValue (audioProcessor.getFeedback());
+    feedbackSlider.addListener (this);
+    addAndMakeVisible (feedbackSlider);
+    feedbackAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("feedback"), feedbackSlider);
+    
+    wetDrySlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    wetDrySlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
+    wetDrySlider.setNormalisableRange(juce::NormalisableRange<double>(0.0, 1.0, 0.01));
+    wetDrySlider.setValue(audioProcessor.getWetDryRatio());
+    wetDrySlider.addListener(this);
+    addAndMakeVisible(wetDrySlider);
+    wetDryAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("wetDryRatio"), wetDrySlider);
+    
+    riserLengthSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    riserLengthSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 80, 20);
+    riserLengthSlider.setNormalisableRange(juce::NormalisableRange<double>(3.0, 7.0, 1.0));
+    riserLengthSlider.setValue(audioProcessor.getRiserLength());
+    riserLengthSlider.addListener(this);
+    addAndMakeVisible(riserLengthSlider);
+    riserLengthAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("riserLength"), riserLengthSlider);
+    
+    accelerateCapSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    accelerateCapSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
+    accelerateCapSlider.setNormalisableRange(juce::NormalisableRange<double>(1.1, 4.0, 0.1));
+    accelerateCapSlider.setValue(audioProcessor.getAccelerateCap());
+    accelerateCapSlider.addListener(this);
+    addAndMakeVisible(accelerateCapSlider);
+    accelerateCapAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("accelerateCap"), accelerateCapSlider);
+    
+    voicesSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    voicesSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 16);
+    addAndMakeVisible(voicesSlider);
+    voicesAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("voices"), voicesSlider);
+    
+    voiceSpreadSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    voiceSpreadSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 16);
+    addAndMakeVisible(voiceSpreadSlider);
+    voiceSpreadAttachment = std::make_unique<ThrottledSliderAttachment>(
+            *audioProcessor.getAPVTS().getParameter("voiceSpread"), voiceSpreadSlider);
+    
+    stereoLinkButton.setButtonText("Link");
+    addAndMakeVisible(stereoLinkButton);
+    stereoLinkAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+            audioProcessor.getAPVTS(), "stereoLink", stereoLinkButton);
+    
+    interpolationBox.addItemList({ "Linear", "Hermite", "Sinc" }, 1);
+    addAndMakeVisible(interpolationBox);
+    interpolationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+            audioProcessor.getAPVTS(), "interpolation", interpolationBox);
+    
+    saturationBox.addItemList({ "Hard Clip", "Soft Clip", "Tanh" }, 1);
+    addAndMakeVisible(saturationBox);
+    saturationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+            audioProcessor.getAPVTS(), "saturation", saturationBox);
+    
+    antialiasingButton.setButtonText("ADAA");
+    addAndMakeVisible(antialiasingButton);
+    antialiasingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+            audioProcessor.getAPVTS(), "antialiasing", antialiasingButton);
+    
+    addAndMakeVisible(riserVisualiser);
+    
+    loadButton.setTooltip("DSP load p50 / p99 / max, click to save the load report (.csv or .txt)");
+    loadButton.onClick = [this] { saveLoadReport(); };
+    addAndMakeVisible(loadButton);
+    timerCallback();
+    startTimerHz(4);
+
+//    addAndMakeVisible(delayTimeLabel);
+    delayTimeLabel.setText("Delay Time", juce::dontSendNotification);
+//    delayTimeLabel.attachToComponent(&delayTimeSlider, false);
+
+    addAndMakeVisible(feedbackLabel);
+    feedbackLabel.setText("Feedback", juce::dontSendNotification);
+//    feedbackLabel.attachToComponent(&feedbackSlider, false);
+
+    addAndMakeVisible(wetDryLabel);
+    wetDryLabel.setText("Wet/Dry", juce::dontSendNotification);
+//    wetDryLabel.attachToComponent(&wetDrySlider, false);
+    
+    addAndMakeVisible(riserLengthLabel);
+    riserLengthLabel.setText("Riser Length", juce::dontSendNotification);
+//    riserLengthLabel.attachToComponent(&riserLengthSlider, false);
+    
+    addAndMakeVisible(accelerateCapLabel);
+    accelerateCapLabel.setText("Accelerate Cap", juce::dontSendNotification);
+//    accelerateCapLabel.attachToComponent(&accelerateCapSlider, false);
+    
+    addAndMakeVisible(voicesLabel);
+    voicesLabel.setText("Voices", juce::dontSendNotification);
+    
+    addAndMakeVisible(voiceSpreadLabel);
+    voiceSpreadLabel.setText("Spread", juce::dontSendNotification);
+    
+    addAndMakeVisible(riserNoteLabel);
+    riserNoteLabel.setText("1/4", juce::dontSendNotification);
+    
+    addAndMakeVisible(noteLabel);
+    noteLabel.setText("Note", juce::dontSendNotification);
+    
+}
+
+RiseUpAudioProcessorEditor::~RiseUpAudioProcessorEditor()
+{
+    stopTimer();
+}
+
+void RiseUpAudioProcessorEditor::timerCallback()
+{
+    const auto statistics = audioProcessor.getLoadMeter().getStatistics();
+    auto percent = [] (double load) { return juce::String(juce::roundToInt(load * 100.0)); };
+    
+    loadButton.setButtonText("DSP " + percent(statistics.p50) + " / " + percent(statistics.p99) + " / " + percent(statistics.maxLoad) + "%");
+}
+
+void RiseUpAudioProcessorEditor::saveLoadReport()
+{
+    loadReportChooser = std::make_unique<juce::FileChooser>("Save the DSP load report",
+                                                            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                                                .getChildFile("RiseUp load.csv"),
+                                                            "*.csv;*.txt");
+    
+    loadReportChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting,
+                                   [this] (const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+        
+        if (file == juce::File())
+            return;
+        
+        const auto& loadMeter = audioProcessor.getLoadMeter();
+        file.replaceWithText(file.hasFileExtension("txt") ? loadMeter.createReport() : loadMeter.createCSV());
+    });
+}
+
+//==============================================================================
+void RiseUpAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    if (backgroundImage.isNull())
+    {
+        // (Our component is opaque, so we must completely fill the background with a solid colour)
+        g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+        return;
+    }
+
+//    g.setColour (juce::Colours::white);
+//    g.setFont (15.0f);
+    
+//    the background is only rescaled when the editor size or the display scale changes, every other repaint
+//    (usually just the bounds of a slider that moved) copies the cached pixels 1:1 inside the clip region
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (scale != scaledBackgroundScale || scaledBackground.getBounds() != getScaledBackgroundBounds(scale))
+        updateScaledBackground(scale);
+    
+    g.drawImageTransformed(scaledBackground, juce::AffineTransform::scale(1.0f / scaledBackgroundScale));
+
+//    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+}
+
+juce::Rectangle<int> RiseUpAudioProcessorEditor::getScaledBackgroundBounds(float scale) const
+{
+    return { juce::roundToInt((float) getWidth() * scale), juce::roundToInt((float) getHeight() * scale) };
+}
+
+void RiseUpAudioProcessorEditor::updateScaledBackground(float scale)
+{
+    const auto bounds = getScaledBackgroundBounds(scale);
+    scaledBackground = backgroundImage.rescaled(juce::jmax(1, bounds.getWidth()), juce::jmax(1, bounds.getHeight()),
+                                                juce::Graphics::highResamplingQuality);
+    scaledBackgroundScale = scale;
+}
+
+void RiseUpAudioProcessorEditor::resized()
+{
+    // This is generally where you'll want to lay out the positions of any
+    // subcomponents in your editor..
+    
+    int sliderWidth = 100;
+    int sliderHeight = 100;
+    int labelHeight = 20;
+    
+    delayTimeSlider.setBounds(20, 20, sliderWidth, sliderHeight);
+//    delayTimeLabel.setBounds(25, 20 + sliderHeight, sliderWidth, labelHeight);
+
+    feedbackSlider.setBounds(25, 190, sliderWidth, sliderHeight);
+    feedbackLabel.setBounds(40, 175, sliderWidth, labelHeight);
+
+    wetDrySlider.setBounds(285, 190, sliderWidth, sliderHeight);
+    wetDryLabel.setBounds(305, 175, sliderWidth, labelHeight);
+    
+    riserLengthSlider.setBounds(155, 110, 85, 85);
+    riserLengthLabel.setBounds(155, 90, 85, labelHeight);
+    
+    accelerateCapSlider.setBounds(285, 20, sliderWidth, sliderHeight);
+    accelerateCapLabel.setBounds(285, 5, sliderWidth, labelHeight);
+    
+    voicesSlider.setBounds(15, 25, 65, 70);
+    voicesLabel.setBounds(25, 5, 65, labelHeight);
+    
+    voiceSpreadSlider.setBounds(85, 25, 65, 70);
+    voiceSpreadLabel.setBounds(95, 5, 65, labelHeight);
+    
+    stereoLinkButton.setBounds(170, 265, 60, labelHeight);
+    interpolationBox.setBounds(150, 238, 100, 22);
+    saturationBox.setBounds(150, 211, 100, 22);
+    antialiasingButton.setBounds(290, 120, 70, labelHeight);
+    riserVisualiser.setBounds(155, 10, 125, 60);
+    loadButton.setBounds(155, 72, 125, 16);
+    
+    riserNoteLabel.setBounds(riserLengthSlider.getX()+23, riserLengthSlider.getY() + 30, 40, 10);
+    riserNoteLabel.setJustificationType(juce::Justification::centred);
+    noteLabel.setBounds(riserLengthSlider.getX()+23, riserLengthSlider.getY() + 45, 40, 10);
+    
+    riserLengthSlider.toFront(true);
+}
+
+void RiseUpAudioProcessorEditor::sliderValueChanged (juce::Slider* slider)
+{
+    // Handle slider value changes and update processor parameters
+    if (slider == &delayTimeSlider)
+    {
+        audioProcessor.setDelayTime(static_cast<float>(delayTimeSlider.getValue()));
+        riserLengthSlider.setValue(delayTimeSlider.getValue()+2.0);
+        audioProcessor.setRiserLength(static_cast<float>(riserLengthSlider.getValue()));
+    }
+    else if (slider == &feedbackSlider)
+    {
+        audioProcessor.setFeedback(static_cast<float>(feedbackSlider.getValue()));
+    }
+    else if (slider == &wetDrySlider)
+    {
+        audioProcessor.setWetDryRatio(static_cast<float>(wetDrySlider.getValue()));
+    }
+    else if (slider == &riserLengthSlider)
+    {
+        audioProcessor.setRiserLength(static_cast<float>(riserLengthSlider.getValue()));
+        delayTimeSlider.setValue(riserLengthSlider.getValue()-2.0);
+        audioProcessor.setDelayTime(static_cast<float>(delayTimeSlider.getValue()));
+        setNoteWithLength(static_cast<float>(riserLengthSlider.getValue()));
+    }
+    else if (slider == &accelerateCapSlider)
+    {
+        audioProcessor.setAccelerateCap(static_cast<float>(accelerateCapSlider.getValue()));
+    }
+    
+}
+
+void RiseUpAudioProcessorEditor::setNoteWithLength(float newRiserLength){
+    switch ((int)newRiserLength) {
+        case 1:
+            riserNoteLabel.setText("1/32", juce::dontSendNotification); // 1/32 note
+            break;
+        case 2:
+            riserNoteLabel.setText("1/16", juce::dontSendNotification); // 1/16 note
+            break;
+        case 3:
+            riserNoteLabel.setText("1/8", juce::dontSendNotification); // 1/8 note
+            break;
+        case 4:
+            riserNoteLabel.setText("1/4", juce::dontSendNotification); // 1/4 note
+            break;
+        case 5:
+            riserNoteLabel.setText("1/2", juce::dontSendNotification); // 1/2 note
+            break;
+        case 6:
+            riserNoteLabel.setText("1", juce::dontSendNotification);// 1 bar
+            break;
+        case 7:
+            riserNoteLabel.setText("2", juce::dontSendNotification); // 2 bard
+            break;
+            
+        default:
+            riserNoteLabel.setText("1/4", juce::dontSendNotification);
+            break;
+    }
+}
@@ -1,58 +1,91 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-#include "RiserLine.h"
-
-//==============================================================================
-/**
-*/
-class RiseUpAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Slider::Listener
-{
-public:
-    RiseUpAudioProcessorEditor (RiseUpAudioProcessor&);
-    ~RiseUpAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-    
-    void sliderValueChanged (juce::Slider* slider) override;
-
-private:
-    // This reference is provided as a quick way for your editor to
-    // access the processor object that created it.
-    RiseUpAudioProcessor& audioProcessor;
-    
-    juce::Slider delayTimeSlider;
-    juce::Slider feedbackSlider;
-    juce::Slider wetDrySlider;
-    juce::Slider riserLengthSlider;
-    juce::Slider accelerateCapSlider;
-    
-    juce::Label delayTimeLabel;
-    juce::Label feedbackLabel;
-    juce::Label wetDryLabel;
-    juce::Label riserLengthLabel;
-    juce::Label accelerateCapLabel;
-    juce::Label riserNoteLabel;
-    juce::Label noteLabel;
-    
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> delayTimeAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> feedbackAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> wetDryAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> riserLengthAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> accelerateCapAttachment;
-    
-    void setNoteWithLength(float riserLength);
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RiseUpAudioProcessorEditor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "RiserLine.h"
+#include "ThrottledSliderAttachment.h"
+#include "RiserVisualiser.h"
+
+//==============================================================================
+/**
+*/
+class RiseUpAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Slider::Listener, private juce::Timer
+{
+public:
+    RiseUpAudioProcessorEditor (RiseUpAudioProcessor&);
+    ~RiseUpAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    
+    void sliderValueChanged (juce::Slider* slider) override;
+
+private:
+    // This reference is provided as a quick way for your editor to
+    // access the processor object that created it.
+    RiseUpAudioProcessor& audioProcessor;
+    
+    juce::Slider delayTimeSlider;
+    juce::Slider feedbackSlider;
+    juce::Slider wetDrySlider;
+    juce::Slider riserLengthSlider;
+    juce::Slider accelerateCapSlider;
+    juce::Slider voicesSlider;
+    juce::Slider voiceSpreadSlider;
+    
+    juce::ToggleButton stereoLinkButton;
+    juce::ComboBox interpolationBox;
+    juce::ComboBox saturationBox;
+    juce::ToggleButton antialiasingButton;
+    
+    RiserVisualiser riserVisualiser;
+    
+//    shows the DSP load of the processor's blocks (p50 / p99 / max) and saves the load report when clicked
+    juce::TextButton loadButton;
+    std::unique_ptr<juce::FileChooser> loadReportChooser;
+    void saveLoadReport();
+    void timerCallback() override;
+    
+    juce::Label delayTimeLabel;
+    juce::Label feedbackLabel;
+    juce::Label wetDryLabel;
+    juce::Label riserLengthLabel;
+    juce::Label accelerateCapLabel;
+    juce::Label voicesLabel;
+    juce::Label voiceSpreadLabel;
+    juce::Label riserNoteLabel;
+    juce::Label noteLabel;
+    
+    std::unique_ptr<ThrottledSliderAttachment> delayTimeAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> feedbackAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> wetDryAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> riserLengthAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> accelerateCapAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> voicesAttachment;
+    std::unique_ptr<ThrottledSliderAttachment> voiceSpreadAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> stereoLinkAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> interpolationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> saturationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> antialiasingAttachment;
+    
+    void setNoteWithLength(float riserLength);
+    
+//    the background PNG, and a copy of it scaled to the editor's size in physical pixels for 'scaledBackgroundScale'
+    juce::Image backgroundImage;
+    juce::Image scaledBackground;
+    float scaledBackgroundScale = 0.0f;
+    
+    juce::Rectangle<int> getScaledBackgroundBounds(float scale) const;
+    void updateScaledBackground(float scale);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RiseUpAudioProcessorEditor)
+};
@@ -1,264 +1,962 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-#include "RiserLine.h"
-
-//==============================================================================
-RiseUpAudioProcessor::RiseUpAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ), delayTime(3.0f), riserLength(5.0f), feedback(0.3f), wetDryRatio(0.5f), apvts(*this, nullptr, "PARAMETERS", createParameterLayout())
-#endif
-{
-    
-    riserLine.reset(new RiserLine(delayTime, riserLength));
-
-}
-
-RiseUpAudioProcessor::~RiseUpAudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String RiseUpAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool RiseUpAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool RiseUpAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool RiseUpAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double RiseUpAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int RiseUpAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int RiseUpAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void RiseUpAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String RiseUpAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void RiseUpAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void RiseUpAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
-    
-    riserLine->prepare(delayTime, riserLength, accelerateCap, feedback, hostBPM, getSampleRate());
-}
-
-void RiseUpAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool RiseUpAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-
-void RiseUpAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-    
-    delayTime = *apvts.getRawParameterValue("delayTime");
-    feedback = *apvts.getRawParameterValue("feedback");
-    wetDryRatio = *apvts.getRawParameterValue("wetDryRatio");
-    riserLength = *apvts.getRawParameterValue("riserLength");
-    accelerateCap = *apvts.getRawParameterValue("accelerateCap");
-    
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    
-    if (auto bpmFromHost = *getPlayHead()->getPosition()->getBpm())
-        hostBPM = bpmFromHost;
-    
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        if (channel > 0) {
-            buffer.copyFrom(channel, 0, buffer, 0, 0, buffer.getNumSamples());
-            break;
-        
-        }
-
-        auto channelData = buffer.getWritePointer(0);
-        auto channelReader = buffer.getReadPointer(0);
-        
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            
-            float wetSample = riserLine->getNextSample(channelReader[i], delayTime, riserLength, feedback, accelerateCap, hostBPM);
-            channelData[i] = wetSample * wetDryRatio + channelReader[i] * (1.0f - wetDryRatio);
-            
-        }
-
-    }
-}
-
-//==============================================================================
-bool RiseUpAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* RiseUpAudioProcessor::createEditor()
-{
-    return new RiseUpAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void RiseUpAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
-}
-
-void RiseUpAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    
-    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
-    
-    if (xmlState.get() != nullptr) {
-        if (xmlState->hasTagName(apvts.state.getType()))
-            apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
-    }
-}
-
-juce::AudioProcessorValueTreeState::ParameterLayout RiseUpAudioProcessor::createParameterLayout()
-{
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-
-    // Add delay time parameter
-    layout.add(std::make_unique<juce::AudioParameterFloat>(delayTimeId, "Delay Time",
-                                                           juce::NormalisableRange<float>(1.0, 5.0, 1.0),
-                                                           3.0f));
-
-    // Add feedback parameter
-    layout.add(std::make_unique<juce::AudioParameterFloat>(feedbackId, "Feedback",
-                                                           juce::NormalisableRange<float>(0.0, 1.0, 0.01),
-                                                           0.3f));
-
-    // Add wet/dry ratio parameter
-    layout.add(std::make_unique<juce::AudioParameterFloat>(wetDryRatioId, "Wet/Dry",
-                                                           juce::NormalisableRange<float>(0.0, 1.0, 0.01),
-                                                           0.5f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>(riserLengthId, "Riser Length",
-                                                           juce::NormalisableRange<float>(3.0, 7.0, 1.0),
-                                                           5.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>(accelerateCapId, "Accelerate Cap",
-                                                           juce::NormalisableRange<float>(1.1, 4.0, 0.1),
-                                                           4.0f));
-
-    return layout;
-}
-
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new RiseUpAudioProcessor();
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "RiserLine.h"
+#include "RealtimeSafety.h"
+
+//==============================================================================
+RiseUpAudioProcessor::RiseUpAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       ), apvts(*this, nullptr, "PARAMETERS", createParameterLayout())
+#endif
+{
+    delayTime = apvts.getRawParameterValue(delayTimeId.getParamID());
+    riserLength = apvts.getRawParameterValue(riserLengthId.getParamID());
+    feedback = apvts.getRawParameterValue(feedbackId.getParamID());
+    accelerateCap = apvts.getRawParameterValue(accelerateCapId.getParamID());
+    wetDryRatio = apvts.getRawParameterValue(wetDryRatioId.getParamID());
+    stereoLink = apvts.getRawParameterValue(stereoLinkId.getParamID());
+    interpolation = apvts.getRawParameterValue(interpolationId.getParamID());
+    voices = apvts.getRawParameterValue(voicesId.getParamID());
+    voiceSpread = apvts.getRawParameterValue(voiceSpreadId.getParamID());
+    saturation = apvts.getRawParameterValue(saturationId.getParamID());
+    antialiasing = apvts.getRawParameterValue(antialiasingId.getParamID());
+    
+    const auto presetParameterIds = getPresetParameterIds();
+    
+    for (size_t i = 0; i < presetParameterIds.size(); ++i)
+        presetParameters[i] = apvts.getRawParameterValue(presetParameterIds[i].getParamID());
+    
+    startTimer(pendingUpdateInterval);
+}
+
+RiseUpAudioProcessor::~RiseUpAudioProcessor()
+{
+    stopTimer();
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+const juce::String RiseUpAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool RiseUpAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool RiseUpAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool RiseUpAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double RiseUpAudioProcessor::getTailLengthSeconds() const
+{
+    return tailLengthSeconds.load();
+}
+
+int RiseUpAudioProcessor::getNumPrograms()
+{
+    return presets.getNumPresets();   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                                      // so this should be at least 1, even if you're not really implementing programs.
+}
+
+int RiseUpAudioProcessor::getCurrentProgram()
+{
+    return currentProgram.load();
+}
+
+void RiseUpAudioProcessor::setCurrentProgram (int index)
+{
+    if (! juce::isPositiveAndBelow(index, presets.getNumPresets()))
+        return;
+    
+    currentProgram = index;
+    
+//    processBlock() starts the fade before any of the new values can reach it, and takes the program's values from the
+//    snapshot rather than the parameters being written
+    ++numProgramChangesRequested;
+    const auto& values = presets.getValues(index);
+    
+    for (size_t i = 0; i < values.size(); ++i)
+        pendingProgramValues[i] = values[i];
+    
+    pendingProgram = index;
+    
+//    hosts may change programs from the audio thread, the parameters are only written from the message thread (where the
+//    timer notices the change if it came from anywhere else, nothing is posted from here)
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        writeProgramParameters();
+}
+
+void RiseUpAudioProcessor::writeProgramParameters()
+{
+    const auto requested = numProgramChangesRequested.load();
+    const auto& values = presets.getValues(currentProgram);
+    const auto presetParameterIds = getPresetParameterIds();
+    
+    for (size_t i = 0; i < presetParameterIds.size(); ++i)
+        setParameterValue(presetParameterIds[i], values[i]);
+    
+    numProgramChangesWritten = requested;
+}
+
+const juce::String RiseUpAudioProcessor::getProgramName (int index)
+{
+    return presets.getName(index);
+}
+
+void RiseUpAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    presets.setName(index, newName);
+}
+
+std::array<juce::ParameterID, PresetBank::numParameters> RiseUpAudioProcessor::getPresetParameterIds() const
+{
+    return { delayTimeId, feedbackId, wetDryRatioId, riserLengthId, accelerateCapId,
+             interpolationId, voicesId, voiceSpreadId, saturationId, antialiasingId };
+}
+
+//==============================================================================
+void RiseUpAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    // Use this method as the place to do any pre-playback
+    // initialisation that you need..
+    
+    feedbackSmoother.reset(sampleRate, smoothingTime);
+    accelerateCapSmoother.reset(sampleRate, smoothingTime);
+    wetDryRatioSmoother.reset(sampleRate, smoothingTime);
+    feedbackSmoother.setCurrentAndTargetValue(*feedback);
+    accelerateCapSmoother.setCurrentAndTargetValue(*accelerateCap);
+    wetDryRatioSmoother.setCurrentAndTargetValue(*wetDryRatio);
+    
+    programFadeLength = juce::jmax(1, (int) (sampleRate * programFadeTime));
+    programFade = ProgramFade::none;
+    overridingParameters = false;
+    appliedValues = getParameterValues();
+    
+    tempoEngine.prepare(sampleRate);
+    loadMeter.prepare(sampleRate);
+    prepareRiserLines();
+    
+//    the host's block size makes no difference to the chunks, only the channels and the precision size them
+    const int numChunkChannels = juce::jlimit(1, RiserLineBase::maxChannels, getTotalNumInputChannels());
+    const bool doublePrecisionChunks = getProcessingPrecision() == doublePrecision;
+    chunks.setSize(doublePrecisionChunks ? 0 : numChunkChannels);
+    doubleChunks.setSize(doublePrecisionChunks ? numChunkChannels : 0);
+    chunkPosition = 0;
+}
+
+void RiseUpAudioProcessor::prepareRiserLines()
+{
+    const int numChannels = juce::jlimit(1, RiserLineBase::maxChannels, getTotalNumOutputChannels());
+    riserLinesLinked = *stereoLink >= 0.5f;
+    
+    riserLines.clear();
+    doubleRiserLines.clear();
+    lastNumRiserSwitches = 0;
+    lastNumBufferResizes = 0;
+    riserLinesRebuilt = true;
+    
+    const auto ecoMode = getEcoMode();
+    ecoFactor = ecoMode == EcoMode::quarter ? 4 : (ecoMode == EcoMode::half ? 2 : 1);
+
+//    the host sets the precision before prepareToPlay(), so it can't change under processBlock()
+    int resamplerLatency = 0;
+    
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        addRiserLines(doubleRiserLines, numChannels);
+        doubleChunks.prepareEco(ecoFactor, numChannels);
+        resamplerLatency = doubleChunks.resampler.getLatencyInSamples();
+    }
+    else
+    {
+        addRiserLines(riserLines, numChannels);
+        chunks.prepareEco(ecoFactor, numChannels);
+        resamplerLatency = chunks.resampler.getLatencyInSamples();
+    }
+    
+//    eco mode starts and stops the FIFO and the resampling, and with them the latency
+    chunks.clear();
+    doubleChunks.clear();
+    chunkPosition = 0;
+    setLatencySamples(ecoFactor > 1 ? chunkSize + resamplerLatency : 0);
+    
+//    the tail of the new RiserLines, which the first block works out again for the values it runs with
+    updateTailLength();
+    tailLengthInputs = {};
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::addRiserLines(juce::OwnedArray<RiserLine<SampleType>>& lines, int numChannels)
+{
+//    the memory limit is shared out evenly between the RiserLines
+    const auto storage = getRiserStorage();
+    const size_t limitPerLine = getMemoryLimit() / (size_t) (riserLinesLinked ? 1 : numChannels);
+    
+    if (riserLinesLinked)
+    {
+        lines.add(new RiserLine<SampleType>(*delayTime, *riserLength));
+        lines[0]->setRiserStorage(storage);
+        lines[0]->setMemoryLimit(limitPerLine);
+        lines[0]->prepare(*delayTime, *riserLength, *accelerateCap, *feedback, tempoEngine.getTempo(), getSampleRate() / ecoFactor, numChannels);
+        return;
+    }
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* line = lines.add(new RiserLine<SampleType>(*delayTime, *riserLength));
+        line->setRiserPhase((float) channel / (float) numChannels);
+        line->setRiserStorage(storage);
+        line->setMemoryLimit(limitPerLine);
+        line->prepare(*delayTime, *riserLength, *accelerateCap, *feedback, tempoEngine.getTempo(), getSampleRate() / ecoFactor, 1);
+    }
+}
+
+void RiseUpAudioProcessor::updateTailLength()
+{
+    double tailLength = 0.0;
+    
+    forEachRiserLine([&tailLength] (auto& line) { tailLength = juce::jmax(tailLength, line.getTailLengthInSamples()); });
+    
+//    the RiserLines count their tails at their own rate, and all of the output comes the latency late (the chunk FIFO
+//    and the resampler in eco mode)
+    if (getSampleRate() > 0.0)
+        tailLengthSeconds = (tailLength * ecoFactor + getLatencySamples()) / getSampleRate();
+}
+
+void RiseUpAudioProcessor::updateTailLengthIfChanged()
+{
+    const auto timeSignature = tempoEngine.getTimeSignature();
+    const std::array<double, 6> inputs { appliedValues[PresetBank::delayTime], appliedValues[PresetBank::riserLength],
+                                         feedbackSmoother.getCurrentValue(), tempoEngine.getTempo(),
+                                         (double) timeSignature.numerator, (double) timeSignature.denominator };
+    
+    if (inputs == tailLengthInputs)
+        return;
+    
+    tailLengthInputs = inputs;
+    updateTailLength();
+}
+
+size_t RiseUpAudioProcessor::getMemoryFootprint() const
+{
+    size_t footprint = 0;
+    
+    forEachRiserLine([&footprint] (auto& line) { footprint += line.getMemoryFootprint(); });
+    
+//    eco mode's filter histories, only held for the processing precision
+    footprint += chunks.resampler.getSizeInBytes() + doubleChunks.resampler.getSizeInBytes();
+    
+    return footprint;
+}
+
+void RiseUpAudioProcessor::setMemoryLimit(size_t maxBytes)
+{
+    apvts.state.setProperty(memoryLimitId, (juce::int64) maxBytes, nullptr);
+    rebuildRiserLines();
+}
+
+size_t RiseUpAudioProcessor::getMemoryLimit() const
+{
+    return (size_t) juce::jmax((juce::int64) 0, (juce::int64) apvts.state.getProperty(memoryLimitId, 0));
+}
+
+void RiseUpAudioProcessor::setRiserStorage(RiserLineBase::RiserStorage storage)
+{
+    apvts.state.setProperty(riserStorageId, storage == RiserLineBase::RiserStorage::int16 ? "int16" : "float32", nullptr);
+    rebuildRiserLines();
+}
+
+RiserLineBase::RiserStorage RiseUpAudioProcessor::getRiserStorage() const
+{
+    return apvts.state.getProperty(riserStorageId).toString() == "int16" ? RiserLineBase::RiserStorage::int16
+                                                                          : RiserLineBase::RiserStorage::float32;
+}
+
+void RiseUpAudioProcessor::setEcoMode(EcoMode mode)
+{
+    apvts.state.setProperty(ecoModeId, mode == EcoMode::quarter ? "quarter" : (mode == EcoMode::half ? "half" : "off"), nullptr);
+    rebuildRiserLines();
+}
+
+RiseUpAudioProcessor::EcoMode RiseUpAudioProcessor::getEcoMode() const
+{
+    const auto mode = apvts.state.getProperty(ecoModeId).toString();
+    
+    if (mode == "quarter")
+        return EcoMode::quarter;
+    
+    return mode == "half" ? EcoMode::half : EcoMode::off;
+}
+
+juce::uint32 RiseUpAudioProcessor::getNumAlignmentResets() const
+{
+    juce::uint32 numResets = 0;
+    forEachRiserLine([&numResets] (auto& line) { numResets += line.getNumAlignmentResets(); });
+    return numResets;
+}
+
+bool RiseUpAudioProcessor::isMemoryLimited() const
+{
+    bool limited = false;
+    forEachRiserLine([&limited] (auto& line) { limited = limited || line.isMemoryLimited(); });
+    return limited;
+}
+
+void RiseUpAudioProcessor::setParameterValue(const juce::ParameterID& parameterId, float newValue)
+{
+    if (auto* parameter = apvts.getParameter(parameterId.getParamID()))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(newValue));
+}
+
+void RiseUpAudioProcessor::rebuildRiserLines()
+{
+    riserLinesNeedRebuilding = true;
+    triggerAsyncUpdate();
+}
+
+void RiseUpAudioProcessor::timerCallback()
+{
+    if (riserLinesNeedRebuilding || numProgramChangesWritten != numProgramChangesRequested)
+        handleAsyncUpdate();
+}
+
+void RiseUpAudioProcessor::handleAsyncUpdate()
+{
+    if (numProgramChangesWritten != numProgramChangesRequested)
+        writeProgramParameters();
+    
+    if (! riserLinesNeedRebuilding.exchange(false))
+        return;
+    
+    suspendProcessing(true);
+    prepareRiserLines();
+    suspendProcessing(false);
+}
+
+void RiseUpAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool RiseUpAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // Any layout from mono up to 7.1 surround works, every channel gets its own lane in the RiserLine.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    const int numOutputChannels = layouts.getMainOutputChannelSet().size();
+    
+    if (numOutputChannels < 1 || numOutputChannels > RiserLineBase::maxChannels)
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+
+void RiseUpAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, false);
+}
+
+void RiseUpAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, false);
+}
+
+void RiseUpAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, true);
+}
+
+void RiseUpAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, true);
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, bool bypassed)
+{
+    const auto startTicks = LoadMeter::getTicks();
+    
+    // reports any allocation or lock in here when built with RISEUP_REALTIME_CHECKS (see RealtimeSafety.h)
+    RealtimeSafety::ScopedRealtimeSection realtimeSection;
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    // This is the place where you'd normally do the guts of your plugin's
+    // audio processing...
+    // Make sure to reset the state if your inner loop is processing
+    // the samples and the outer loop is handling the channels.
+    // Alternatively, you can process the samples with the channels
+    // interleaved by keeping the same state.
+    
+    auto& chunk = getChunkBuffers<SampleType>();
+    const int numChannels = juce::jmin(totalNumInputChannels, chunk.input.getNumChannels());
+    
+//    no RiserLines of this precision until prepareToPlay() has run for it, the input passes through dry meanwhile
+    if (numChannels == 0 || getRiserLines<SampleType>().isEmpty())
+        return;
+    
+    const bool telemetryActive = telemetry.isActive();
+    const bool throughFifo = chunk.resampler.getFactor() > 1;
+    juce::uint32 numProgramChanges = 0;
+
+//    the play head and every field of its position are optional, tempoEngine keeps the last tempo it saw. It's read at the
+//    start of every host block, even one that starts part way into a chunk, so the positions the pieces of the block are
+//    given are counted from this block's start rather than the last one's (which the RiserLines would take for a jump)
+    tempoEngine.update(getPlayHead());
+    
+//    bypassed, the input stays as it is and the next block processed starts a new chunk (in eco mode it still goes
+//    through the FIFO, so it comes out as late as it does when processed)
+    if (bypassed && ! throughFifo)
+    {
+        chunkPosition = 0;
+        addBlockToLoadMeter(startTicks, buffer.getNumSamples(), numProgramChanges);
+        return;
+    }
+    
+//    the host block is cut where it crosses the chunk grid. At the start of every chunk the parameters and the play head are
+//    read for the whole chunk, and each piece is processed with the part of the chunk it covers. In eco mode every sample
+//    instead goes into the chunk being gathered and is swapped for the one at the same place in the last chunk's output,
+//    and whenever a chunk is full it's processed
+    for (int start = 0; start < buffer.getNumSamples();)
+    {
+        const int numSamples = juce::jmin(chunkSize - chunkPosition, buffer.getNumSamples() - start);
+        
+        if (throughFifo)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                chunk.input.copyFrom(channel, chunkPosition, buffer, channel, start, numSamples);
+                buffer.copyFrom(channel, start, chunk.output, channel, chunkPosition, numSamples);
+            }
+            
+            if (chunkPosition + numSamples < chunkSize)
+            {
+                chunkPosition += numSamples;
+                break;
+            }
+            
+            if (bypassed)
+            {
+                chunk.delayDry(numChannels);
+                
+                for (int channel = 0; channel < numChannels; ++channel)
+                    chunk.output.copyFrom(channel, 0, chunk.input, channel, 0, chunkSize);
+                
+                start += numSamples;
+                chunkPosition = 0;
+                continue;
+            }
+        }
+        
+        if (chunkPosition == 0 || throughFifo)
+        {
+//            the stereo link setting changes the number of RiserLines, so they are rebuilt on the message thread
+//            (which the timer notices, nothing is posted from here)
+            const bool linked = *stereoLink >= 0.5f;
+            
+            if (linked != riserLinesLinked)
+                riserLinesNeedRebuilding = true;
+            
+            if (updateProgramChange())
+                ++numProgramChanges;
+            
+            prepareChunkParams();
+        }
+        
+        if (throughFifo)
+        {
+            processChunk(chunk, start + numSamples - chunkSize, numChannels);
+            
+            if (telemetryActive)
+                pushTelemetry(chunk.output, 0, chunkSize, numChannels);
+        }
+        else
+        {
+            processInPlace(buffer, start, numSamples, numChannels);
+            
+            if (telemetryActive)
+                pushTelemetry(buffer, start, numSamples, numChannels);
+        }
+        
+        start += numSamples;
+        chunkPosition = (chunkPosition + numSamples) % chunkSize;
+    }
+    
+    updateTailLengthIfChanged();
+    
+    addBlockToLoadMeter(startTicks, buffer.getNumSamples(), numProgramChanges);
+}
+
+void RiseUpAudioProcessor::addBlockToLoadMeter(juce::int64 startTicks, int numSamples, juce::uint32 numProgramChanges)
+{
+    juce::uint32 numRiserSwitches = 0;
+    juce::uint32 numBufferResizes = 0;
+    
+    forEachRiserLine([&numRiserSwitches, &numBufferResizes] (auto& line)
+    {
+        numRiserSwitches += line.getNumRiserSwitches();
+        numBufferResizes += line.getNumBufferResizes();
+    });
+    
+    LoadMeter::EventCounts events {};
+    events[LoadMeter::riserSwitch] = numRiserSwitches - lastNumRiserSwitches;
+    events[LoadMeter::bufferResize] = numBufferResizes - lastNumBufferResizes;
+    events[LoadMeter::programChange] = numProgramChanges;
+    events[LoadMeter::riserLinesRebuilt] = riserLinesRebuilt ? 1 : 0;
+    
+    lastNumRiserSwitches = numRiserSwitches;
+    lastNumBufferResizes = numBufferResizes;
+    riserLinesRebuilt = false;
+    
+    loadMeter.addBlock(startTicks, numSamples, events, appliedValues);
+}
+
+bool RiseUpAudioProcessor::updateProgramChange()
+{
+    const int requested = pendingProgram.exchange(-1);
+    
+//    fade out with the values the last sub-block ran with, whatever the parameters have been changed to since
+//    (a change during the fade in fades back out from where it got to)
+    if (requested >= 0)
+    {
+        overrideValues = appliedValues;
+        overridingParameters = true;
+        
+        for (size_t i = 0; i < programFadeValues.size(); ++i)
+            programFadeValues[i] = pendingProgramValues[i].load();
+        
+        if (programFade == ProgramFade::fadingIn)
+            programFadePosition = programFadeLength - juce::jmin(programFadePosition, programFadeLength);
+        else if (programFade == ProgramFade::none)
+            programFadePosition = 0;
+        
+        programFade = ProgramFade::fadingOut;
+    }
+    
+//    once only the dry signal is left, every setting switches to the program at once
+    if (programFade == ProgramFade::fadingOut && programFadePosition >= programFadeLength)
+    {
+        overrideValues = programFadeValues;
+        feedbackSmoother.setCurrentAndTargetValue(overrideValues[PresetBank::feedback]);
+        accelerateCapSmoother.setCurrentAndTargetValue(overrideValues[PresetBank::accelerateCap]);
+        wetDryRatioSmoother.setCurrentAndTargetValue(overrideValues[PresetBank::wetDryRatio]);
+        
+        programFade = ProgramFade::fadingIn;
+        programFadePosition = 0;
+        return true;
+    }
+    
+    if (programFade == ProgramFade::none && overridingParameters && numProgramChangesWritten == numProgramChangesRequested)
+        overridingParameters = false;
+    
+    return false;
+}
+
+PresetBank::Values RiseUpAudioProcessor::getParameterValues() const
+{
+    if (overridingParameters)
+        return overrideValues;
+
+//    a program being written to the parameters on the message thread would come out half old and half new, so the
+//    last values are kept if a write was going on, or started, while they were read (and by the time it's over
+//    updateProgramChange() has started the fade)
+    const auto numWritten = numProgramChangesWritten.load();
+    const auto numRequested = numProgramChangesRequested.load();
+    PresetBank::Values values;
+    
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = presetParameters[i]->load();
+    
+    if (numWritten != numRequested || numProgramChangesRequested.load() != numRequested)
+        return appliedValues;
+    
+    return values;
+}
+
+void RiseUpAudioProcessor::applyProgramFade(RiserLineBase::Params& params, int numSamples)
+{
+    if (params.wetDryRatioRamp == nullptr)
+        std::fill(wetDryRatioRamp.begin(), wetDryRatioRamp.begin() + numSamples, params.wetDryRatio);
+    
+    const bool fadingOut = programFade == ProgramFade::fadingOut;
+    const float step = 1.0f / (float) programFadeLength;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float position = (float) juce::jmin(programFadePosition + i, programFadeLength) * step;
+        wetDryRatioRamp[(size_t) i] *= fadingOut ? 1.0f - position : position;
+    }
+    
+    params.wetDryRatioRamp = wetDryRatioRamp.data();
+    params.wetDryRatio = wetDryRatioRamp[(size_t) numSamples - 1];
+    
+    programFadePosition += numSamples;
+    
+    if (! fadingOut && programFadePosition >= programFadeLength)
+        programFade = ProgramFade::none;
+}
+
+void RiseUpAudioProcessor::prepareChunkParams()
+{
+    const auto values = getParameterValues();
+    appliedValues = values;
+    
+    feedbackSmoother.setTargetValue(values[PresetBank::feedback]);
+    accelerateCapSmoother.setTargetValue(values[PresetBank::accelerateCap]);
+    wetDryRatioSmoother.setTargetValue(values[PresetBank::wetDryRatio]);
+    
+    RiserLineBase::Params params;
+    params.delayTime = values[PresetBank::delayTime];
+    params.riserLength = values[PresetBank::riserLength];
+    params.tempo = tempoEngine.getTempo();
+    params.timeSignature = tempoEngine.getTimeSignature();
+    params.hasPosition = tempoEngine.hasPosition();
+    params.ppqPositionOfLastBarStart = tempoEngine.getPpqPositionOfLastBarStart();
+    params.interpolation = (Interpolation::Quality) (int) values[PresetBank::interpolation];
+    params.numVoices = (int) values[PresetBank::voices];
+    params.voiceSpread = values[PresetBank::voiceSpread];
+    params.saturation = (Saturation::Curve) (int) values[PresetBank::saturation];
+    params.antialiasing = values[PresetBank::antialiasing] >= 0.5f;
+    
+//    the smoothers hand back no ramp while they hold still, which keeps RiserLine on its constant parameter path
+    params.feedbackRamp = feedbackSmoother.getNextValues(feedbackRamp.data(), chunkSize);
+    params.accelerateCapRamp = accelerateCapSmoother.getNextValues(accelerateCapRamp.data(), chunkSize);
+    params.wetDryRatioRamp = wetDryRatioSmoother.getNextValues(wetDryRatioRamp.data(), chunkSize);
+    params.feedback = feedbackSmoother.getCurrentValue();
+    params.accelerateCap = accelerateCapSmoother.getCurrentValue();
+    params.wetDryRatio = wetDryRatioSmoother.getCurrentValue();
+    
+    if (programFade != ProgramFade::none)
+        applyProgramFade(params, chunkSize);
+    
+    chunkParams = params;
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::processInPlace(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples, int numChannels)
+{
+//    the position is this block's, even when the chunk started in the one before
+    auto params = chunkParams;
+    params.hasPosition = tempoEngine.hasPosition();
+    params.ppqPosition = tempoEngine.getPpqPosition(start);
+    params.ppqPositionOfLastBarStart = tempoEngine.getPpqPositionOfLastBarStart();
+    
+    if (params.feedbackRamp != nullptr)
+        params.feedbackRamp += chunkPosition;
+    
+    if (params.accelerateCapRamp != nullptr)
+        params.accelerateCapRamp += chunkPosition;
+    
+    if (params.wetDryRatioRamp != nullptr)
+        params.wetDryRatioRamp += chunkPosition;
+    
+    const SampleType* input[RiserLineBase::maxChannels];
+    SampleType* output[RiserLineBase::maxChannels];
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        input[channel] = buffer.getReadPointer(channel, start);
+        output[channel] = buffer.getWritePointer(channel, start);
+    }
+    
+    runRiserLines(input, output, numChannels, numSamples, params);
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::processChunk(ChunkBuffers<SampleType>& chunk, int playHeadOffset, int numChannels)
+{
+    auto params = chunkParams;
+    params.ppqPosition = tempoEngine.getPpqPosition(playHeadOffset);
+    
+    const SampleType* input[RiserLineBase::maxChannels];
+    SampleType* output[RiserLineBase::maxChannels];
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        input[channel] = chunk.input.getReadPointer(channel);
+        output[channel] = chunk.output.getWritePointer(channel);
+    }
+
+//    the RiserLines run wet only on the decimated chunk, with every ramp but the wet/dry one (which the mix at the full
+//    rate uses) decimated along with it
+    const int factor = chunk.resampler.getFactor();
+    const float* fullRateWetDryRatioRamp = params.wetDryRatioRamp;
+    const float fullRateWetDryRatio = params.wetDryRatio;
+    
+    chunk.resampler.decimate(input, chunk.ecoInput.getArrayOfWritePointers(), numChannels, chunkSize);
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        input[channel] = chunk.ecoInput.getReadPointer(channel);
+        output[channel] = chunk.ecoOutput.getWritePointer(channel);
+    }
+    
+    params.feedbackRamp = decimateRamp(params.feedbackRamp, feedbackRamp.data(), factor);
+    params.accelerateCapRamp = decimateRamp(params.accelerateCapRamp, accelerateCapRamp.data(), factor);
+    params.wetDryRatioRamp = nullptr;
+    params.wetDryRatio = 1.0f;
+    
+    runRiserLines(input, output, numChannels, chunkSize / factor, params);
+    
+    chunk.delayDry(numChannels);
+    mixEcoWetSignal(chunk, numChannels, fullRateWetDryRatioRamp, fullRateWetDryRatio);
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::runRiserLines(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples,
+                                         const RiserLineBase::Params& params)
+{
+    auto& lines = getRiserLines<SampleType>();
+    
+    if (riserLinesLinked)
+    {
+        lines[0]->processBlock(input, output, numChannels, numSamples, params);
+    }
+    else
+    {
+        for (int channel = 0; channel < juce::jmin(numChannels, lines.size()); ++channel)
+            lines[channel]->processBlock(input[channel], output[channel], numSamples, params);
+    }
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::mixEcoWetSignal(ChunkBuffers<SampleType>& chunk, int numChannels, const float* wetDryRatioRamp, float wetDryRatio)
+{
+    chunk.resampler.interpolate(chunk.ecoOutput.getArrayOfReadPointers(), chunk.output.getArrayOfWritePointers(), numChannels, chunkSize);
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const SampleType* dry = chunk.input.getReadPointer(channel);
+        SampleType* output = chunk.output.getWritePointer(channel);
+        
+        if (wetDryRatioRamp == nullptr)
+        {
+            juce::FloatVectorOperations::multiply(output, (SampleType) wetDryRatio, chunkSize);
+            juce::FloatVectorOperations::addWithMultiply(output, dry, (SampleType) (1.0f - wetDryRatio), chunkSize);
+            continue;
+        }
+        
+        for (int i = 0; i < chunkSize; ++i)
+            output[i] = output[i] * (SampleType) wetDryRatioRamp[i] + dry[i] * (SampleType) (1.0f - wetDryRatioRamp[i]);
+    }
+}
+
+const float* RiseUpAudioProcessor::decimateRamp(const float* values, float* ramp, int factor)
+{
+    if (values == nullptr)
+        return nullptr;
+    
+    for (int i = 0; i < chunkSize / factor; ++i)
+        ramp[i] = values[(i + 1) * factor - 1];
+    
+    return ramp;
+}
+
+template <typename SampleType>
+void RiseUpAudioProcessor::pushTelemetry(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numChannels)
+{
+    auto& lines = getRiserLines<SampleType>();
+    
+    if (lines.isEmpty())
+        return;
+    
+    const auto* line = lines[0];
+    
+    Telemetry::Frame frame;
+    frame.riserProgress = line->getRiserProgress();
+    frame.playbackSpeed = (float) line->getPlaybackSpeed();
+    frame.riserSwitches = line->getNumRiserSwitches();
+    frame.numSamples = numSamples;
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel, startSample), numSamples);
+        frame.outputMin = juce::jmin(frame.outputMin, (float) range.getStart());
+        frame.outputMax = juce::jmax(frame.outputMax, (float) range.getEnd());
+    }
+    
+//    a full FIFO means the editor is behind, the frame is dropped rather than waited for
+    telemetry.push(frame);
+}
+
+//==============================================================================
+bool RiseUpAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* RiseUpAudioProcessor::createEditor()
+{
+    return new RiseUpAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void RiseUpAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // You should use this method to store your parameters in the memory block.
+    // You could do that either as raw data, or use the XML or ValueTree classes
+    // as intermediaries to make it easy to save and load complex data.
+    
+    auto state = apvts.copyState();
+    state.setProperty(programId, getCurrentProgram(), nullptr);
+    state.setProperty(programNamesId, presets.getNames().joinIntoString("\n"), nullptr);
+    
+//    the binary ValueTree format is written and read back without going through XML text
+    juce::MemoryOutputStream stream(destData, false);
+    state.writeToStream(stream);
+}
+
+void RiseUpAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+    
+    juce::ValueTree state;
+    
+    // sessions saved before the binary format hold the state as XML
+    if (auto xmlState = getXmlFromBinary(data, sizeInBytes))
+        state = juce::ValueTree::fromXml(*xmlState);
+    else
+        state = juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
+    
+    if (! state.hasType(apvts.state.getType()))
+        return;
+    
+    // the program is only restored as the current one, the parameters below already hold its values
+    if (state.hasProperty(programNamesId))
+        presets.setNames(juce::StringArray::fromLines(state.getProperty(programNamesId).toString()));
+    
+    currentProgram = juce::jlimit(0, presets.getNumPresets() - 1, (int) state.getProperty(programId, 0));
+    state.removeProperty(programId, nullptr);
+    state.removeProperty(programNamesId, nullptr);
+    
+    const auto oldLimit = getMemoryLimit();
+    const auto oldStorage = getRiserStorage();
+    const auto oldEcoMode = getEcoMode();
+    
+    apvts.replaceState(state);
+    
+    // the RiserLines are only rebuilt when the restored memory or eco settings are different
+    if (getMemoryLimit() != oldLimit || getRiserStorage() != oldStorage || getEcoMode() != oldEcoMode)
+        rebuildRiserLines();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout RiseUpAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    // Add delay time parameter
+    layout.add(std::make_unique<juce::AudioParameterFloat>(delayTimeId, "Delay Time",
+                                                           juce::NormalisableRange<float>(1.0, 5.0, 1.0),
+                                                           3.0f));
+
+    // Add feedback parameter
+    layout.add(std::make_unique<juce::AudioParameterFloat>(feedbackId, "Feedback",
+                                                           juce::NormalisableRange<float>(0.0, 1.0, 0.01),
+                                                           0.3f));
+
+    // Add wet/dry ratio parameter
+    layout.add(std::make_unique<juce::AudioParameterFloat>(wetDryRatioId, "Wet/Dry",
+                                                           juce::NormalisableRange<float>(0.0, 1.0, 0.01),
+                                                           0.5f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(riserLengthId, "Riser Length",
+                                                           juce::NormalisableRange<float>(3.0, 7.0, 1.0),
+                                                           5.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(accelerateCapId, "Accelerate Cap",
+                                                           juce::NormalisableRange<float>(1.1, 4.0, 0.1),
+                                                           4.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>(stereoLinkId, "Stereo Link", true));
+    
+    // the order of the choices follows Interpolation::Quality
+    layout.add(std::make_unique<juce::AudioParameterChoice>(interpolationId, "Interpolation",
+                                                            juce::StringArray { "Linear", "Hermite", "Sinc" },
+                                                            0));
+    
+    // more voices give a denser riser for the cost of a read each, see RiserVoices
+    layout.add(std::make_unique<juce::AudioParameterInt>(voicesId, "Voices", 1, RiserVoices::maxVoices, 1));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(voiceSpreadId, "Voice Spread",
+                                                           juce::NormalisableRange<float>(0.0, 1.0, 0.01),
+                                                           0.5f));
+    
+    // the order of the choices follows Saturation::Curve, the antialiasing costs about as much again as the curve
+    layout.add(std::make_unique<juce::AudioParameterChoice>(saturationId, "Saturation",
+                                                            juce::StringArray { "Hard Clip", "Soft Clip", "Tanh" },
+                                                            0));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>(antialiasingId, "Antialiasing", false));
+
+    return layout;
+}
+
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new RiseUpAudioProcessor();
+}
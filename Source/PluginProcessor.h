@@ -1,99 +1,428 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "RiserLine.h"
-
-//==============================================================================
-/**
-*/
-class RiseUpAudioProcessor  : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    RiseUpAudioProcessor();
-    ~RiseUpAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    //==============================================================================
-    
-    float getDelayTime() const { return delayTime; }
-    void setDelayTime(float newDelayTime) { delayTime = newDelayTime; }
-//    void setDelayBufferSize(float newDelayTime);
-
-    float getFeedback() const { return feedback; }
-    void setFeedback(float newFeedback) { feedback = newFeedback; }
-    
-    float getWetDryRatio() const { return wetDryRatio; }
-    void setWetDryRatio(float newWetDryRatio) { wetDryRatio = newWetDryRatio; }
-    
-    float getRiserLength() const { return riserLength; }
-    void setRiserLength(float newRiserLength) { riserLength = newRiserLength; }
-//    void setRiserBufferSize(float newRiserLength);
-    
-    float getAccelerateCap() const { return accelerateCap; }
-    void setAccelerateCap(float newAccelerateCap) { accelerateCap = newAccelerateCap; }
-    
-    juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
-    juce::ParameterID delayTimeId = juce::ParameterID("delayTime", 1);
-    juce::ParameterID feedbackId = juce::ParameterID("feedback", 1);
-    juce::ParameterID wetDryRatioId = juce::ParameterID("wetDryRatio", 1);
-    juce::ParameterID riserLengthId = juce::ParameterID("riserLength", 1);
-    juce::ParameterID accelerateCapId = juce::ParameterID("accelerateCap", 1);
-
-private:
-    float delayTime; // mapped to notes with setDelayBufferSize();
-    float riserLength; // mapped to notes with setRiserBufferSize();
-    float feedback; 
-    float accelerateCap = 0.5f;
-    float wetDryRatio;
-    double hostBPM = 120;
-
-    std::unique_ptr<RiserLine> riserLine;
-    
-    juce::AudioProcessorValueTreeState apvts;
-    
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RiseUpAudioProcessor)
-};
-
-//==============================================================================
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RiserLine.h"
+#include "ParameterSmoother.h"
+#include "TempoEngine.h"
+#include "Telemetry.h"
+#include "PresetBank.h"
+#include "LoadMeter.h"
+#include "EcoResampler.h"
+
+//==============================================================================
+/**
+*/
+class RiseUpAudioProcessor  : public juce::AudioProcessor, private juce::AsyncUpdater, private juce::Timer
+{
+public:
+    //==============================================================================
+    RiseUpAudioProcessor();
+    ~RiseUpAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    // bypassed, the input passes through as it is (in eco mode through the chunk FIFO, so it comes out as late as it does
+    // when processed)
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    // double precision hosts get RiserLine<double>, so their samples are never converted to float and back
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    //==============================================================================
+    
+    // the setters go through the parameters (and so the host), they're safe to call from the message thread
+    float getDelayTime() const { return delayTime->load(); }
+    void setDelayTime(float newDelayTime) { setParameterValue(delayTimeId, newDelayTime); }
+//    void setDelayBufferSize(float newDelayTime);
+
+    float getFeedback() const { return feedback->load(); }
+    void setFeedback(float newFeedback) { setParameterValue(feedbackId, newFeedback); }
+    
+    float getWetDryRatio() const { return wetDryRatio->load(); }
+    void setWetDryRatio(float newWetDryRatio) { setParameterValue(wetDryRatioId, newWetDryRatio); }
+    
+    float getRiserLength() const { return riserLength->load(); }
+    void setRiserLength(float newRiserLength) { setParameterValue(riserLengthId, newRiserLength); }
+//    void setRiserBufferSize(float newRiserLength);
+    
+    float getAccelerateCap() const { return accelerateCap->load(); }
+    void setAccelerateCap(float newAccelerateCap) { setParameterValue(accelerateCapId, newAccelerateCap); }
+    
+    juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
+    
+    // the bytes held by the RiserLines' buffers
+    size_t getMemoryFootprint() const;
+    
+    // the most memory the RiserLines may take between them (0 for no limit) and how they store the riser signal.
+    // Both are saved with the plugin state and rebuild the RiserLines, so only set them from the message thread
+    void setMemoryLimit(size_t maxBytes);
+    size_t getMemoryLimit() const;
+    
+    void setRiserStorage(RiserLineBase::RiserStorage storage);
+    RiserLineBase::RiserStorage getRiserStorage() const;
+    
+    // true when the memory limit cuts the longest note lengths at slow tempos short
+    bool isMemoryLimited() const;
+    
+    // how many times the RiserLines have moved their riser pointers to follow the host position, between them
+    // (prepareToPlay() and rebuilding the RiserLines start it over)
+    juce::uint32 getNumAlignmentResets() const;
+    
+    // eco mode runs the RiserLines at a half or a quarter of the sample rate, for about that much less CPU and buffer memory.
+    // The wet signal loses everything above a quarter or an eighth of the sample rate, the dry signal stays at the full
+    // rate and is held back by EcoResampler's latency to stay in line with it. That and the chunk FIFO are reported to the
+    // host as latency. Saved with the state like the memory settings, and it rebuilds the RiserLines too
+    enum class EcoMode
+    {
+        off,
+        half,
+        quarter
+    };
+    
+    void setEcoMode(EcoMode mode);
+    EcoMode getEcoMode() const;
+    
+    // the riser telemetry processBlock() reports while it's active, for one consumer (the editor's RiserVisualiser)
+    Telemetry::Fifo& getTelemetry() { return telemetry; }
+    
+    // the timing of every processBlock(), readable from any thread
+    LoadMeter& getLoadMeter() { return loadMeter; }
+    
+    juce::ParameterID delayTimeId = juce::ParameterID("delayTime", 1);
+    juce::ParameterID feedbackId = juce::ParameterID("feedback", 1);
+    juce::ParameterID wetDryRatioId = juce::ParameterID("wetDryRatio", 1);
+    juce::ParameterID riserLengthId = juce::ParameterID("riserLength", 1);
+    juce::ParameterID accelerateCapId = juce::ParameterID("accelerateCap", 1);
+    juce::ParameterID stereoLinkId = juce::ParameterID("stereoLink", 1);
+    juce::ParameterID interpolationId = juce::ParameterID("interpolation", 1);
+    juce::ParameterID voicesId = juce::ParameterID("voices", 1);
+    juce::ParameterID voiceSpreadId = juce::ParameterID("voiceSpread", 1);
+    juce::ParameterID saturationId = juce::ParameterID("saturation", 1);
+    juce::ParameterID antialiasingId = juce::ParameterID("antialiasing", 1);
+    
+    // the ids of the parameters a preset sets, in the order of PresetBank::Parameter
+    std::array<juce::ParameterID, PresetBank::numParameters> getPresetParameterIds() const;
+
+private:
+    TempoEngine tempoEngine;
+
+//    linked: one RiserLine running every channel in lockstep, unlinked: one RiserLine per channel with staggered riser phases.
+//    Only the array for the processing precision holds any, the other one stays empty
+    juce::OwnedArray<RiserLine<float>> riserLines;
+    juce::OwnedArray<RiserLine<double>> doubleRiserLines;
+    bool riserLinesLinked = true;
+    
+    template <typename SampleType>
+    juce::OwnedArray<RiserLine<SampleType>>& getRiserLines() noexcept
+    {
+        if constexpr (std::is_same<SampleType, double>::value)
+            return doubleRiserLines;
+        else
+            return riserLines;
+    }
+    
+//    call 'function' with every RiserLine of either precision
+    template <typename Function>
+    void forEachRiserLine(Function&& function) const
+    {
+        for (auto* line : riserLines)
+            function(*line);
+        
+        for (auto* line : doubleRiserLines)
+            function(*line);
+    }
+    
+//    holds on to the shared tables so they aren't freed and rebuilt every time riserLines is
+    juce::SharedResourcePointer<SharedTables> sharedTables;
+    
+//    (re)build riserLines for the current channel count, stereo link setting and processing precision, never call this
+//    from the audio thread
+    void prepareRiserLines();
+    
+    template <typename SampleType>
+    void addRiserLines(juce::OwnedArray<RiserLine<SampleType>>& lines, int numChannels);
+    
+//    the longest tail of the riserLines at their current feedback and note lengths plus the latency, for
+//    getTailLengthSeconds(). processBlock() only works it out again when the note lengths, the feedback or the tempo it
+//    was worked out for ('tailLengthInputs') have changed
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    std::array<double, 6> tailLengthInputs {};
+    void updateTailLength();
+    void updateTailLengthIfChanged();
+    
+//    rebuilds riserLines off the audio thread when the stereo link or memory settings change, and writes a program
+//    change the host made off the message thread to the parameters
+    void handleAsyncUpdate() override;
+    
+//    the audio thread only sets flags (posting a message locks the message queue and can allocate), the timer polls them
+//    on the message thread every 'pendingUpdateInterval' ms and hands them on to handleAsyncUpdate()
+    static constexpr int pendingUpdateInterval = 50;
+    void timerCallback() override;
+    
+    std::atomic<bool> riserLinesNeedRebuilding { false };
+    
+//    from the message thread, the audio thread sets riserLinesNeedRebuilding instead
+    void rebuildRiserLines();
+    
+//    the ids of the memory settings in the state, which aren't parameters since changing them reallocates
+    juce::Identifier memoryLimitId = juce::Identifier("memoryLimit");
+    juce::Identifier riserStorageId = juce::Identifier("riserStorage");
+    juce::Identifier ecoModeId = juce::Identifier("ecoMode");
+    
+//    the RiserLines run at 1/ecoFactor of the sample rate, set with them by prepareRiserLines()
+    int ecoFactor = 1;
+    
+//    the current program and the program names are added to the saved state
+    juce::Identifier programId = juce::Identifier("program");
+    juce::Identifier programNamesId = juce::Identifier("programNames");
+    
+    juce::AudioProcessorValueTreeState apvts;
+    
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+//    the parameter values, looked up once in the constructor so processBlock() never searches for them by name
+    std::atomic<float>* delayTime = nullptr; // mapped to notes with setDelayBufferSize();
+    std::atomic<float>* riserLength = nullptr; // mapped to notes with setRiserBufferSize();
+    std::atomic<float>* feedback = nullptr;
+    std::atomic<float>* accelerateCap = nullptr;
+    std::atomic<float>* wetDryRatio = nullptr;
+    std::atomic<float>* stereoLink = nullptr;
+    std::atomic<float>* interpolation = nullptr;
+    std::atomic<float>* voices = nullptr;
+    std::atomic<float>* voiceSpread = nullptr;
+    std::atomic<float>* saturation = nullptr;
+    std::atomic<float>* antialiasing = nullptr;
+    
+//    the same values in the order of PresetBank::Parameter
+    std::array<std::atomic<float>*, PresetBank::numParameters> presetParameters {};
+    
+    void setParameterValue(const juce::ParameterID& parameterId, float newValue);
+    
+//    processBlock() reads the parameters and the play head once per chunk of 'chunkSize' samples whatever size of block the
+//    host sends (the size of RiserLine's own chunks, a whole number of SIMDRegisters), so a change that arrives while a host
+//    block is running takes effect at the next chunk. The chunks are a grid running on from one host block to the next
+//    ('chunkPosition' is how far into the current one the next sample is): host blocks are processed in place, cut where
+//    they cross the grid, with no latency. Only eco mode, whose resampler needs whole chunks, gathers the samples of a chunk
+//    in 'input' while the chunk before plays out of 'output', which delays the output by 'chunkSize' samples (reported to
+//    the host as the latency, with the resampler's)
+    static constexpr int chunkSize = 64;
+    
+    template <typename SampleType>
+    struct ChunkBuffers
+    {
+        void setSize(int numChannels)
+        {
+            input.setSize(numChannels, chunkSize);
+            output.setSize(numChannels, chunkSize);
+            clear();
+        }
+        
+        void clear()
+        {
+            input.clear();
+            output.clear();
+            dryDelay.clear();
+            dryDelayPosition = 0;
+        }
+        
+        juce::AudioBuffer<SampleType> input;
+        juce::AudioBuffer<SampleType> output;
+        
+//        in eco mode the chunk goes through 'resampler' to and from the RiserLines' rate, in 'ecoInput' and 'ecoOutput', and
+//        the dry signal waits in 'dryDelay' for as long as that takes
+        void prepareEco(int factor, int numChannels)
+        {
+            resampler.prepare(factor, numChannels, chunkSize);
+            ecoInput.setSize(factor > 1 ? numChannels : 0, chunkSize / factor);
+            ecoOutput.setSize(factor > 1 ? numChannels : 0, chunkSize / factor);
+            dryDelay.setSize(factor > 1 ? numChannels : 0, factor > 1 ? resampler.getLatencyInSamples() : 0);
+            dryDelay.clear();
+            dryDelayPosition = 0;
+        }
+        
+//        swap the chunk's input for the input the resampler's latency earlier, so the dry signal lines up with the wet one
+        void delayDry(int numChannels)
+        {
+            const int length = dryDelay.getNumSamples();
+            
+            if (length == 0)
+                return;
+            
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* samples = input.getWritePointer(channel);
+                auto* delayed = dryDelay.getWritePointer(channel);
+                int position = dryDelayPosition;
+                
+                for (int i = 0; i < chunkSize; ++i)
+                {
+                    std::swap(samples[i], delayed[position]);
+                    
+                    if (++position == length)
+                        position = 0;
+                }
+            }
+            
+            dryDelayPosition = (dryDelayPosition + chunkSize) % length;
+        }
+        
+        EcoResampler<SampleType> resampler;
+        juce::AudioBuffer<SampleType> ecoInput;
+        juce::AudioBuffer<SampleType> ecoOutput;
+        juce::AudioBuffer<SampleType> dryDelay;
+        int dryDelayPosition = 0;
+    };
+    
+//    like the RiserLines, only the chunk buffers for the processing precision hold any samples
+    ChunkBuffers<float> chunks;
+    ChunkBuffers<double> doubleChunks;
+    int chunkPosition = 0; // how far into the current chunk processBlock() is
+    
+//    the parameters read at the start of the current chunk, with ramps for all of it
+    RiserLineBase::Params chunkParams;
+    
+    template <typename SampleType>
+    ChunkBuffers<SampleType>& getChunkBuffers() noexcept
+    {
+        if constexpr (std::is_same<SampleType, double>::value)
+            return doubleChunks;
+        else
+            return chunks;
+    }
+    
+//    feedback, wet/dry and accelerateCap ramp to every new value over 'smoothingTime' seconds, one ramp buffer for each
+    static constexpr double smoothingTime = 0.02;
+    ParameterSmoother feedbackSmoother;
+    ParameterSmoother accelerateCapSmoother;
+    ParameterSmoother wetDryRatioSmoother;
+    std::array<float, chunkSize> feedbackRamp;
+    std::array<float, chunkSize> accelerateCapRamp;
+    std::array<float, chunkSize> wetDryRatioRamp;
+    
+//    the body of the processBlock()s, bypassed each chunk is copied to the output as it is
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, bool bypassed);
+    
+//    read the parameters and work out their ramps for the chunk starting now, into 'chunkParams'
+    void prepareChunkParams();
+    
+//    run the RiserLines in place over 'numSamples' samples of 'buffer' from 'start', 'chunkPosition' samples into the chunk
+    template <typename SampleType>
+    void processInPlace(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples, int numChannels);
+    
+//    eco mode: run the RiserLines from the chunk's input to its output at the reduced rate. 'playHeadOffset' is where the
+//    chunk starts in the host block tempoEngine was last updated for (negative when it started in an earlier block)
+    template <typename SampleType>
+    void processChunk(ChunkBuffers<SampleType>& chunk, int playHeadOffset, int numChannels);
+    
+    template <typename SampleType>
+    void runRiserLines(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples,
+                       const RiserLineBase::Params& params);
+    
+//    bring the RiserLines' wet signal back up from the eco rate and mix it with the chunk's dry input at the full rate
+    template <typename SampleType>
+    void mixEcoWetSignal(ChunkBuffers<SampleType>& chunk, int numChannels, const float* wetDryRatioRamp, float wetDryRatio);
+    
+//    the last of every 'factor' values of a ramp, written over its start for RiserLines running at 1/factor of the rate
+//    (so it still ends on the current value). No ramp stays no ramp
+    static const float* decimateRamp(const float* values, float* ramp, int factor);
+    
+    PresetBank presets;
+    std::atomic<int> currentProgram { 0 };
+    
+//    A program change fades the wet signal out with the old settings, switches every setting at once while only the dry
+//    signal is heard and fades the new settings back in. setCurrentProgram() writes the program to the parameters
+//    straight away, but processBlock() goes on with the values it ran with until the fade out is over, then uses the
+//    program's values (the snapshot setCurrentProgram() took, never the parameters mid-write) until every parameter has
+//    been written ('numProgramChangesWritten' has caught up)
+    std::atomic<int> pendingProgram { -1 };
+    std::array<std::atomic<float>, PresetBank::numParameters> pendingProgramValues {};   // written before pendingProgram
+    std::atomic<juce::uint32> numProgramChangesRequested { 0 };
+    std::atomic<juce::uint32> numProgramChangesWritten { 0 };
+    
+    void writeProgramParameters();
+    
+    enum class ProgramFade
+    {
+        none,
+        fadingOut,
+        fadingIn
+    };
+    
+    static constexpr double programFadeTime = 0.01; // for each of the fades
+    ProgramFade programFade = ProgramFade::none;
+    int programFadeLength = 1;
+    int programFadePosition = 0;
+    PresetBank::Values programFadeValues {};   // the program being faded to, as it was when the change was requested
+    
+//    the values the last sub-block ran with, and the values used instead of the parameters during a program change
+    PresetBank::Values appliedValues {};
+    PresetBank::Values overrideValues {};
+    bool overridingParameters = false;
+    
+//    start, switch or finish a program change at the start of a sub-block, true when the settings switched to the program
+    bool updateProgramChange();
+    
+//    the parameter values for the next sub-block
+    PresetBank::Values getParameterValues() const;
+    
+//    scale the wet/dry ratio ramp by the program change fade
+    void applyProgramFade(RiserLineBase::Params& params, int numSamples);
+    
+//    one telemetry frame for every parameter interval, taken from the first RiserLine and the output of every channel
+    Telemetry::Fifo telemetry;
+    template <typename SampleType>
+    void pushTelemetry(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numChannels);
+    
+//    the events of a block are worked out from the RiserLines' counters since the last block
+//    (prepareRiserLines() starts them over, with processing suspended)
+    LoadMeter loadMeter;
+    juce::uint32 lastNumRiserSwitches = 0;
+    juce::uint32 lastNumBufferResizes = 0;
+    bool riserLinesRebuilt = false;
+    void addBlockToLoadMeter(juce::int64 startTicks, int numSamples, juce::uint32 numProgramChanges);
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RiseUpAudioProcessor)
+};
+
+//==============================================================================
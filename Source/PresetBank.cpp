@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Created: 1 Apr 2024 7:02:58pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+PresetBank::PresetBank()
+{
+//    delayTime, feedback, wetDryRatio, riserLength, accelerateCap, interpolation, voices, voiceSpread, saturation, antialiasing
+//    (the delay time is kept two note lengths under the riser length, the way the editor links them)
+    presets = {
+        { "Default",        { 3.0f, 0.3f, 0.5f, 5.0f, 4.0f, 0.0f, 1.0f, 0.5f, 0.0f, 0.0f } },
+        { "Octave Rise",    { 3.0f, 0.5f, 0.5f, 5.0f, 2.0f, 1.0f, 1.0f, 0.5f, 0.0f, 0.0f } },
+        { "Short Build",    { 2.0f, 0.4f, 0.5f, 4.0f, 2.5f, 1.0f, 2.0f, 0.3f, 1.0f, 0.0f } },
+        { "Long Climb",     { 5.0f, 0.6f, 0.6f, 7.0f, 4.0f, 1.0f, 3.0f, 0.4f, 1.0f, 0.0f } },
+        { "Subtle Lift",    { 4.0f, 0.2f, 0.3f, 6.0f, 1.5f, 1.0f, 1.0f, 0.5f, 1.0f, 0.0f } },
+        { "Dense Swarm",    { 3.0f, 0.4f, 0.7f, 5.0f, 3.0f, 2.0f, 6.0f, 0.8f, 2.0f, 1.0f } },
+        { "Hard Drive",     { 1.0f, 0.9f, 0.6f, 3.0f, 4.0f, 0.0f, 1.0f, 0.5f, 0.0f, 1.0f } }
+    };
+}
+
+const char* PresetBank::getParameterName(Parameter parameter) noexcept
+{
+    switch (parameter)
+    {
+        case delayTime:       return "delayTime";
+        case feedback:        return "feedback";
+        case wetDryRatio:     return "wetDryRatio";
+        case riserLength:     return "riserLength";
+        case accelerateCap:   return "accelerateCap";
+        case interpolation:   return "interpolation";
+        case voices:          return "voices";
+        case voiceSpread:     return "voiceSpread";
+        case saturation:      return "saturation";
+        case antialiasing:    return "antialiasing";
+        case numParameters:
+        default:              return "";
+    }
+}
+
+const PresetBank::Values& PresetBank::getValues(int index) const noexcept
+{
+    return presets[(size_t) juce::jlimit(0, getNumPresets() - 1, index)].values;
+}
+
+juce::String PresetBank::getName(int index) const
+{
+    if (! juce::isPositiveAndBelow(index, getNumPresets()))
+        return {};
+    
+    return presets[(size_t) index].name;
+}
+
+void PresetBank::setName(int index, const juce::String& newName)
+{
+    if (juce::isPositiveAndBelow(index, getNumPresets()))
+        presets[(size_t) index].name = newName;
+}
+
+juce::StringArray PresetBank::getNames() const
+{
+    juce::StringArray names;
+    
+    for (const auto& preset : presets)
+        names.add(preset.name);
+    
+    return names;
+}
+
+void PresetBank::setNames(const juce::StringArray& newNames)
+{
+    for (int i = 0; i < juce::jmin(newNames.size(), getNumPresets()); ++i)
+        presets[(size_t) i].name = newNames[i];
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Created: 1 Apr 2024 7:02:44pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The programs the host can switch between. Every preset is held as a fixed array of plain parameter values, built once
+// when the bank is made and never reallocated, so the audio thread can copy a preset's values without allocating or locking.
+// The stereo link is left out, since changing it rebuilds the RiserLines.
+class PresetBank
+{
+public:
+    // the parameters a preset sets, in the order of its values
+    enum Parameter
+    {
+        delayTime = 0,
+        feedback,
+        wetDryRatio,
+        riserLength,
+        accelerateCap,
+        interpolation,
+        voices,
+        voiceSpread,
+        saturation,
+        antialiasing,
+        numParameters
+    };
+    
+    // the values as the parameters hold them (not normalised), choices and bools as their index
+    using Values = std::array<float, numParameters>;
+    
+    // the parameter's id, e.g. "delayTime"
+    static const char* getParameterName(Parameter parameter) noexcept;
+    
+    // loads the factory presets
+    PresetBank();
+    
+    int getNumPresets() const noexcept { return (int) presets.size(); }
+    
+    // the values of the preset at 'index' (clamped to the bank), safe to call from the audio thread
+    const Values& getValues(int index) const noexcept;
+    
+    // the names can be changed by the host (only from the message thread)
+    juce::String getName(int index) const;
+    void setName(int index, const juce::String& newName);
+    
+    // every name, for saving with the plugin state
+    juce::StringArray getNames() const;
+    void setNames(const juce::StringArray& newNames);
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        Values values;
+    };
+    
+    std::vector<Preset> presets;
+    
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
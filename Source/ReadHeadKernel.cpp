@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    ReadHeadKernel.cpp
+    Created: 11 Feb 2024 4:18:11pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "ReadHeadKernel.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ 
+ // lets the AVX2 gather live in this file without building the whole plugin for AVX2
+ #if JUCE_MSVC
+  #define RISEUP_TARGET_AVX2
+ #else
+  #define RISEUP_TARGET_AVX2 __attribute__ ((target ("avx2")))
+ #endif
+#endif
+
+namespace ReadHeadKernel
+{
+
+void fillPositions(double* positions, int numPositions, double start, double step, double stepIncrement)
+{
+    for (int k = 0; k < numPositions; ++k)
+        positions[k] = getPosition(k, start, step, stepIncrement);
+}
+
+int countPositionsBelow(double limit, int maxPositions, double start, double step, double stepIncrement)
+{
+    if (maxPositions <= 0 || start >= limit)
+        return 0;
+    
+    if (getPosition(maxPositions - 1, start, step, stepIncrement) < limit)
+        return maxPositions;
+    
+//    the positions cross 'limit' at the root of stepIncrement / 2 * k^2 + (step - stepIncrement / 2) * k + start - limit,
+//    which is then nudged onto the positions themselves since they round differently
+    const double a = 0.5 * stepIncrement;
+    const double b = step - a;
+    const double c = start - limit;
+    const double root = a > 0.0 ? (-b + std::sqrt(b * b - 4.0 * a * c)) / (2.0 * a)
+                                : (b > 0.0 ? -c / b : (double) maxPositions);
+    
+    int count = (int) juce::jlimit(0.0, (double) maxPositions, std::ceil(root));
+    
+    while (count > 0 && getPosition(count - 1, start, step, stepIncrement) >= limit)
+        --count;
+    
+    while (count < maxPositions && getPosition(count, start, step, stepIncrement) < limit)
+        ++count;
+    
+    return count;
+}
+
+void gatherScalar(const float* data, const double* positions, float* interpolated, int numPositions)
+{
+    for (int k = 0; k < numPositions; ++k)
+    {
+        const int index = (int) positions[k];
+        const float a = (float) (positions[k] - index);
+        
+        interpolated[k] = (1.0f - a) * data[index] + a * data[index + 1];
+    }
+}
+
+#if JUCE_INTEL
+void gatherSSE(const float* data, const double* positions, float* interpolated, int numPositions)
+{
+    int k = 0;
+    
+    for (; k + 4 <= numPositions; k += 4)
+    {
+//        positions are never negative so truncating is the same as floor()
+        const __m128d positions01 = _mm_loadu_pd(positions + k);
+        const __m128d positions23 = _mm_loadu_pd(positions + k + 2);
+        const __m128i indices01 = _mm_cvttpd_epi32(positions01);
+        const __m128i indices23 = _mm_cvttpd_epi32(positions23);
+        
+        const __m128 fractions = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(positions01, _mm_cvtepi32_pd(indices01))),
+                                               _mm_cvtpd_ps(_mm_sub_pd(positions23, _mm_cvtepi32_pd(indices23))));
+
+//        SSE has no gather, so the 8 reads are scalar loads
+        alignas(16) int indices[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_unpacklo_epi64(indices01, indices23));
+        
+        const __m128 lower = _mm_setr_ps(data[indices[0]], data[indices[1]], data[indices[2]], data[indices[3]]);
+        const __m128 upper = _mm_setr_ps(data[indices[0] + 1], data[indices[1] + 1], data[indices[2] + 1], data[indices[3] + 1]);
+
+//        (1 - a) * lower + a * upper
+        _mm_storeu_ps(interpolated + k, _mm_add_ps(lower, _mm_mul_ps(fractions, _mm_sub_ps(upper, lower))));
+    }
+    
+    gatherScalar(data, positions + k, interpolated + k, numPositions - k);
+}
+
+RISEUP_TARGET_AVX2
+void gatherAVX2(const float* data, const double* positions, float* interpolated, int numPositions)
+{
+    int k = 0;
+    
+    for (; k + 8 <= numPositions; k += 8)
+    {
+        const __m256d positions0 = _mm256_loadu_pd(positions + k);
+        const __m256d positions1 = _mm256_loadu_pd(positions + k + 4);
+        const __m128i indices0 = _mm256_cvttpd_epi32(positions0);
+        const __m128i indices1 = _mm256_cvttpd_epi32(positions1);
+        const __m256i indices = _mm256_inserti128_si256(_mm256_castsi128_si256(indices0), indices1, 1);
+        
+        const __m128 fractions0 = _mm256_cvtpd_ps(_mm256_sub_pd(positions0, _mm256_cvtepi32_pd(indices0)));
+        const __m128 fractions1 = _mm256_cvtpd_ps(_mm256_sub_pd(positions1, _mm256_cvtepi32_pd(indices1)));
+        const __m256 fractions = _mm256_insertf128_ps(_mm256_castps128_ps256(fractions0), fractions1, 1);
+        
+        const __m256 lower = _mm256_i32gather_ps(data, indices, 4);
+        const __m256 upper = _mm256_i32gather_ps(data + 1, indices, 4);
+        
+        _mm256_storeu_ps(interpolated + k, _mm256_add_ps(lower, _mm256_mul_ps(fractions, _mm256_sub_ps(upper, lower))));
+    }
+    
+    gatherSSE(data, positions + k, interpolated + k, numPositions - k);
+}
+#endif
+
+GatherFunction getGatherFunction()
+{
+   #if JUCE_INTEL
+    static const GatherFunction gather = [] () -> GatherFunction
+    {
+        if (juce::SystemStats::hasAVX2())
+            return gatherAVX2;
+        
+        if (juce::SystemStats::hasSSE2())
+            return gatherSSE;
+        
+        return gatherScalar;
+    }();
+    
+    return gather;
+   #else
+    return gatherScalar;
+   #endif
+}
+
+juce::Array<NamedGather> getSupportedGathers()
+{
+    juce::Array<NamedGather> gathers;
+    
+   #if JUCE_INTEL
+    if (juce::SystemStats::hasAVX2())
+        gathers.add({ "avx2", gatherAVX2 });
+    
+    if (juce::SystemStats::hasSSE2())
+        gathers.add({ "sse", gatherSSE });
+   #endif
+    
+    gathers.add({ "scalar", gatherScalar });
+    return gathers;
+}
+
+}
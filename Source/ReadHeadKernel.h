@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ReadHeadKernel.h
+    Created: 11 Feb 2024 4:18:03pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The accelerating read head of the delayBuffer, worked out a run of samples at a time.
+// The play pointer moves by 'step' and the step grows by a fixed increment every sample, so every position of a run
+// has a closed form and the reads can be gathered and interpolated in SIMD lanes instead of one sample at a time.
+namespace ReadHeadKernel
+{
+    // the longest run worked out in one go
+    constexpr int maxRunLength = 64;
+    
+    // position k of a run: start + k * step + stepIncrement * k * (k - 1) / 2, the same positions the per-sample loop
+    // 'position += step; step += stepIncrement' goes through
+    inline double getPosition(int k, double start, double step, double stepIncrement) noexcept
+    {
+        return start + k * step + 0.5 * stepIncrement * k * (k - 1);
+    }
+    
+    // positions[k] = getPosition(k, ...) for every k below 'numPositions'
+    void fillPositions(double* positions, int numPositions, double start, double step, double stepIncrement);
+    
+    // how many positions from the start of a run (up to 'maxPositions') are below 'limit', from the closed form without
+    // filling any. The step and its increment are never negative, so the positions only move forwards
+    int countPositionsBelow(double limit, int maxPositions, double start, double step, double stepIncrement);
+    
+    // the linear interpolation of every (non-negative) position, with i = floor(position) and a = position - i:
+    // interpolated[k] = (1 - a) * data[i] + a * data[i + 1]
+    using GatherFunction = void (*) (const float* data, const double* positions, float* interpolated, int numPositions);
+    
+    void gatherScalar(const float* data, const double* positions, float* interpolated, int numPositions);
+   
+   #if JUCE_INTEL
+    void gatherSSE(const float* data, const double* positions, float* interpolated, int numPositions);
+    void gatherAVX2(const float* data, const double* positions, float* interpolated, int numPositions);
+   #endif
+   
+    // the fastest gather this CPU supports (AVX2, SSE or the scalar fallback), picked once at runtime
+    GatherFunction getGatherFunction();
+    
+    struct NamedGather
+    {
+        const char* name;
+        GatherFunction function;
+    };
+    
+    // every gather this CPU supports, fastest first, so RiseUpRender can time and check each of them
+    juce::Array<NamedGather> getSupportedGathers();
+}
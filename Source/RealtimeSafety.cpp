@@ -0,0 +1,364 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+    Created: 9 Mar 2024 2:20:22pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if RISEUP_REALTIME_CHECKS
+ #include <new>
+ #include <cstdlib>
+ #include <cstddef>
+ #include <cstring>
+ #include <atomic>
+ #if JUCE_LINUX
+  #include <dlfcn.h>
+  #include <pthread.h>
+  #include <semaphore.h>
+  #include <time.h>
+ #endif
+#endif
+
+namespace RealtimeSafety
+{
+
+#if RISEUP_REALTIME_CHECKS
+namespace
+{
+    thread_local int realtimeDepth = 0;
+    thread_local bool reporting = false;
+
+//    recording a violation allocates and locks itself, which 'reporting' keeps from being reported again
+    std::mutex& getViolationLock()
+    {
+        static std::mutex violationLock;
+        return violationLock;
+    }
+    
+    std::vector<Violation>& getViolations()
+    {
+        static std::vector<Violation> violations;
+        return violations;
+    }
+}
+
+void enterRealtimeSection() noexcept
+{
+    ++realtimeDepth;
+}
+
+void exitRealtimeSection() noexcept
+{
+    --realtimeDepth;
+}
+
+bool isInRealtimeSection() noexcept
+{
+    return realtimeDepth > 0 && ! reporting;
+}
+
+void reportViolation(Violation::Type type, const char* function, size_t size) noexcept
+{
+    reporting = true;
+    
+    try
+    {
+        Violation violation { type, function, size, juce::SystemStats::getStackBacktrace() };
+        
+        std::lock_guard<std::mutex> lock(getViolationLock());
+        getViolations().push_back(std::move(violation));
+    }
+    catch (...) {}
+    
+    reporting = false;
+}
+
+std::vector<Violation> takeViolations()
+{
+    std::lock_guard<std::mutex> lock(getViolationLock());
+    std::vector<Violation> violations;
+    violations.swap(getViolations());
+    return violations;
+}
+#else
+std::vector<Violation> takeViolations()
+{
+    return {};
+}
+#endif
+
+juce::String getDescription(const Violation& violation)
+{
+    switch (violation.type)
+    {
+        case Violation::Type::allocation:   return violation.function + " allocated " + juce::String((juce::int64) violation.size) + " bytes";
+        case Violation::Type::deallocation: return violation.function + " freed memory";
+        case Violation::Type::lock:         return violation.function + " took a lock";
+        case Violation::Type::blockingCall:
+        default:                            return violation.function + " blocked";
+    }
+}
+
+}
+
+//==============================================================================
+#if RISEUP_REALTIME_CHECKS
+#if JUCE_LINUX
+// On Linux the malloc family is interposed as well (below), so JUCE's HeapBlock and anything else that allocates without
+// operator new is caught too. These are the C library's own functions, found with dlsym(RTLD_NEXT) the first time any of
+// them is needed. dlsym can allocate while it looks them up, and those allocations come from a small static arena
+// instead, which 'resolving' sends them to.
+namespace
+{
+    struct Allocator
+    {
+        void* (*malloc) (size_t);
+        void* (*calloc) (size_t, size_t);
+        void* (*realloc) (void*, size_t);
+        void (*free) (void*);
+        int (*posixMemalign) (void**, size_t, size_t);
+        void* (*alignedAlloc) (size_t, size_t);
+    };
+    
+    Allocator nextAllocator {};     // constant initialised, so no guard lock
+    thread_local bool resolving = false;
+    
+    alignas(std::max_align_t) char bootstrapMemory[16384];
+    std::atomic<size_t> bootstrapUsed { 0 };
+    
+    bool isBootstrapMemory(const void* memory) noexcept
+    {
+        const auto* bytes = static_cast<const char*>(memory);
+        return bytes >= bootstrapMemory && bytes < bootstrapMemory + sizeof(bootstrapMemory);
+    }
+
+//    never freed or reused, so it's always zeroed, which calloc needs
+    void* allocateBootstrap(size_t size) noexcept
+    {
+        const size_t alignment = alignof(std::max_align_t);
+        const size_t alignedSize = (juce::jmax((size_t) 1, size) + alignment - 1) & ~(alignment - 1);
+        const size_t offset = bootstrapUsed.fetch_add(alignedSize);
+        return offset + alignedSize <= sizeof(bootstrapMemory) ? bootstrapMemory + offset : nullptr;
+    }
+    
+    template <typename Function>
+    void findNext(Function& function, const char* name) noexcept
+    {
+        function = reinterpret_cast<Function> (dlsym(RTLD_NEXT, name));
+    }
+    
+    const Allocator& getNextAllocator() noexcept
+    {
+//        threads racing here all find the same functions
+        if (nextAllocator.free == nullptr)
+        {
+            resolving = true;
+            Allocator next {};
+            findNext(next.malloc, "malloc");
+            findNext(next.calloc, "calloc");
+            findNext(next.realloc, "realloc");
+            findNext(next.posixMemalign, "posix_memalign");
+            findNext(next.alignedAlloc, "aligned_alloc");
+            findNext(next.free, "free");
+            nextAllocator = next;
+            resolving = false;
+        }
+        
+        return nextAllocator;
+    }
+    
+    void* mallocUnchecked(size_t size) noexcept                                  { return getNextAllocator().malloc(size); }
+    int posixMemalignUnchecked(void** memory, size_t alignment, size_t size) noexcept { return getNextAllocator().posixMemalign(memory, alignment, size); }
+    
+    void freeUnchecked(void* memory) noexcept
+    {
+        if (! isBootstrapMemory(memory))
+            getNextAllocator().free(memory);
+    }
+}
+#else
+namespace
+{
+    void* mallocUnchecked(size_t size) noexcept                                  { return std::malloc(size); }
+    int posixMemalignUnchecked(void** memory, size_t alignment, size_t size) noexcept { return posix_memalign(memory, alignment, size); }
+    void freeUnchecked(void* memory) noexcept                                    { std::free(memory); }
+}
+#endif
+
+//    operator new and delete go straight to the C library, so nothing is reported twice through the malloc hooks
+namespace
+{
+    void* allocate(size_t size, const char* function)
+    {
+        if (RealtimeSafety::isInRealtimeSection())
+            RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, function, size);
+        
+        if (auto* memory = mallocUnchecked(size == 0 ? 1 : size))
+            return memory;
+        
+        throw std::bad_alloc();
+    }
+    
+    void* allocateAligned(size_t size, std::align_val_t alignment, const char* function)
+    {
+        if (RealtimeSafety::isInRealtimeSection())
+            RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, function, size);
+        
+        void* memory = nullptr;
+        
+        if (posixMemalignUnchecked(&memory, juce::jmax(sizeof(void*), (size_t) alignment), size == 0 ? 1 : size) == 0)
+            return memory;
+        
+        throw std::bad_alloc();
+    }
+    
+    void deallocate(void* memory, const char* function) noexcept
+    {
+        if (memory != nullptr && RealtimeSafety::isInRealtimeSection())
+            RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::deallocation, function, 0);
+        
+        freeUnchecked(memory);
+    }
+}
+
+// the replaceable global allocation functions, every form new/delete expressions and the standard library use
+void* operator new (size_t size)                                                { return allocate(size, "operator new"); }
+void* operator new[] (size_t size)                                              { return allocate(size, "operator new[]"); }
+void* operator new (size_t size, const std::nothrow_t&) noexcept                { try { return allocate(size, "operator new"); } catch (...) { return nullptr; } }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept              { try { return allocate(size, "operator new[]"); } catch (...) { return nullptr; } }
+void* operator new (size_t size, std::align_val_t alignment)                    { return allocateAligned(size, alignment, "operator new"); }
+void* operator new[] (size_t size, std::align_val_t alignment)                  { return allocateAligned(size, alignment, "operator new[]"); }
+
+void operator delete (void* memory) noexcept                                    { deallocate(memory, "operator delete"); }
+void operator delete[] (void* memory) noexcept                                  { deallocate(memory, "operator delete[]"); }
+void operator delete (void* memory, size_t) noexcept                            { deallocate(memory, "operator delete"); }
+void operator delete[] (void* memory, size_t) noexcept                          { deallocate(memory, "operator delete[]"); }
+void operator delete (void* memory, const std::nothrow_t&) noexcept             { deallocate(memory, "operator delete"); }
+void operator delete[] (void* memory, const std::nothrow_t&) noexcept           { deallocate(memory, "operator delete[]"); }
+void operator delete (void* memory, std::align_val_t) noexcept                  { deallocate(memory, "operator delete"); }
+void operator delete[] (void* memory, std::align_val_t) noexcept                { deallocate(memory, "operator delete[]"); }
+void operator delete (void* memory, size_t, std::align_val_t) noexcept          { deallocate(memory, "operator delete"); }
+void operator delete[] (void* memory, size_t, std::align_val_t) noexcept        { deallocate(memory, "operator delete[]"); }
+
+//==============================================================================
+// On Linux the executable's definitions of these come before libc's and libpthread's, so every allocation and lock made
+// by our code, JUCE or the standard library goes through here first and on to the real function found with
+// dlsym(RTLD_NEXT). (macOS binds symbols per library, so there only operator new and delete are caught.)
+#if JUCE_LINUX
+extern "C" void* malloc(size_t size)
+{
+    if (resolving)
+        return allocateBootstrap(size);
+    
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, "malloc", size);
+    
+    return getNextAllocator().malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    if (resolving)
+        return count != 0 && size > (size_t) -1 / count ? nullptr : allocateBootstrap(count * size);
+    
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, "calloc", count * size);
+    
+    return getNextAllocator().calloc(count, size);
+}
+
+extern "C" void* realloc(void* memory, size_t size)
+{
+    if (resolving)
+    {
+//        anything reallocated before the lookup came from the arena, somewhere before the new block
+        auto* moved = allocateBootstrap(size);
+        
+        if (moved != nullptr && memory != nullptr)
+            std::memcpy(moved, memory, juce::jmin(size, (size_t) (static_cast<char*>(moved) - static_cast<char*>(memory))));
+        
+        return moved;
+    }
+    
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, "realloc", size);
+
+//    the arena doesn't know the size of what it handed out, so copy as much as could have been
+    if (isBootstrapMemory(memory))
+    {
+        auto* moved = getNextAllocator().malloc(size);
+        
+        if (moved != nullptr)
+            std::memcpy(moved, memory, juce::jmin(size, (size_t) (bootstrapMemory + sizeof(bootstrapMemory) - static_cast<char*>(memory))));
+        
+        return moved;
+    }
+    
+    return getNextAllocator().realloc(memory, size);
+}
+
+extern "C" void free(void* memory)
+{
+    if (memory == nullptr || isBootstrapMemory(memory))
+        return;
+    
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::deallocation, "free", 0);
+    
+    getNextAllocator().free(memory);
+}
+
+extern "C" int posix_memalign(void** memory, size_t alignment, size_t size)
+{
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, "posix_memalign", size);
+    
+    return getNextAllocator().posixMemalign(memory, alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size)
+{
+    if (RealtimeSafety::isInRealtimeSection())
+        RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::allocation, "aligned_alloc", size);
+    
+    return getNextAllocator().alignedAlloc(alignment, size);
+}
+
+#define RISEUP_INTERPOSE(returnType, name, parameters, arguments, violationType)                        \
+    extern "C" returnType name parameters                                                               \
+    {                                                                                                   \
+        using Function = returnType (*) parameters;                                                     \
+        static Function next = nullptr; /* constant initialised, so no guard lock */                    \
+                                                                                                        \
+        if (next == nullptr)                                                                            \
+            next = reinterpret_cast<Function> (dlsym(RTLD_NEXT, #name));                                \
+                                                                                                        \
+        if (RealtimeSafety::isInRealtimeSection())                                                      \
+            RealtimeSafety::reportViolation(RealtimeSafety::Violation::Type::violationType, #name, 0);  \
+                                                                                                        \
+        return next arguments;                                                                          \
+    }
+
+RISEUP_INTERPOSE(int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex), lock)
+RISEUP_INTERPOSE(int, pthread_mutex_trylock, (pthread_mutex_t* mutex), (mutex), lock)
+RISEUP_INTERPOSE(int, pthread_spin_lock, (pthread_spinlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_spin_trylock, (pthread_spinlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_rwlock_tryrdlock, (pthread_rwlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_rwlock_trywrlock, (pthread_rwlock_t* lock), (lock), lock)
+RISEUP_INTERPOSE(int, pthread_cond_wait, (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex), blockingCall)
+RISEUP_INTERPOSE(int, pthread_cond_timedwait, (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time), (condition, mutex, time), blockingCall)
+RISEUP_INTERPOSE(int, pthread_join, (pthread_t thread, void** result), (thread, result), blockingCall)
+RISEUP_INTERPOSE(int, sem_wait, (sem_t* semaphore), (semaphore), blockingCall)
+RISEUP_INTERPOSE(int, nanosleep, (const struct timespec* time, struct timespec* remaining), (time, remaining), blockingCall)
+RISEUP_INTERPOSE(int, usleep, (useconds_t microseconds), (microseconds), blockingCall)
+
+#undef RISEUP_INTERPOSE
+#endif
+#endif
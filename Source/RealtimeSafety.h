@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+    Created: 9 Mar 2024 2:20:14pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Catches the things that cause dropouts on the audio thread: heap allocations and frees, and (on Linux) locks and other
+// blocking calls. Code marks its realtime sections with a ScopedRealtimeSection, and while one is open on a thread the
+// replaced global operator new/delete and (on Linux) the interposed malloc family and pthread calls record every hit
+// with a stack trace.
+//
+// The hooks replace operator new/delete for the whole binary, so they are only built when RISEUP_REALTIME_CHECKS is 1.
+// RiseUpRender turns them on in its Debug build for --realtime-check. Plugin builds leave them off, so the plugin never
+// replaces the host's allocator and ScopedRealtimeSection compiles to nothing.
+#ifndef RISEUP_REALTIME_CHECKS
+ #define RISEUP_REALTIME_CHECKS 0
+#endif
+
+namespace RealtimeSafety
+{
+    struct Violation
+    {
+        enum class Type
+        {
+            allocation,
+            deallocation,
+            lock,
+            blockingCall
+        };
+        
+        Type type;
+        juce::String function;      // e.g. "operator new" or "pthread_mutex_lock"
+        size_t size = 0;            // the bytes requested, for allocations
+        juce::String stackTrace;
+    };
+    
+    // true when the hooks are built in, without them no violation is ever recorded
+    constexpr bool isEnabled() { return RISEUP_REALTIME_CHECKS != 0; }
+    
+    // hand back every violation recorded since the last call and clear them
+    std::vector<Violation> takeViolations();
+    
+    juce::String getDescription(const Violation& violation);
+   
+   #if RISEUP_REALTIME_CHECKS
+    void enterRealtimeSection() noexcept;
+    void exitRealtimeSection() noexcept;
+    
+    // called by the hooks
+    bool isInRealtimeSection() noexcept;
+    void reportViolation(Violation::Type type, const char* function, size_t size) noexcept;
+   #endif
+   
+    // marks the calling thread as realtime for its lifetime (sections can nest)
+    struct ScopedRealtimeSection
+    {
+       #if RISEUP_REALTIME_CHECKS
+        ScopedRealtimeSection() noexcept { enterRealtimeSection(); }
+        ~ScopedRealtimeSection() { exitRealtimeSection(); }
+       #else
+        ScopedRealtimeSection() noexcept {}
+       #endif
+       
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+}
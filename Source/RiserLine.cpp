@@ -1,270 +1,879 @@
-/*
-  ==============================================================================
-
-    RiserLine.cpp
-    Created: 17 Dec 2023 5:07:49pm
-    Author:  Zi Meng
-
-  ==============================================================================
-*/
-
-#include "RiserLine.h"
-
-RiserLine::RiserLine(float delayTime, float riserLength){
-    setDelayBufferSize(delayTime);
-    setRiserBufferSize(riserLength);
-    
-    delayBuffer = juce::AudioBuffer<float>(1,  delayBufferSize);
-    riserBuffer1 = juce::AudioBuffer<float>(1,  riserBufferSize);
-    riserBuffer2 = juce::AudioBuffer<float>(1,  riserBufferSize);
-}
-
-RiserLine::~RiserLine(){
-    
-}
-
-void RiserLine::prepare(float delayTime, float riserLength, float newAccelerateCap, float newFeedback, double newTempo, double newSampleRate)
-{
-    setDelayBufferSize(delayTime);
-    setRiserBufferSize(riserLength);
-    accelerateCap = newAccelerateCap;
-    feedback = newFeedback;
-    tempo = newTempo;
-    sampleRate = newSampleRate;
-    
-    dlyWritePtr = 0.0;
-    riserWritePtr1 = 0;
-    riserPlayPtr1 = 0;
-    riserWritePtr2 = 0;
-    riserPlayPtr2 = 0;
-    
-    dlyPlayPtr = dlyWritePtr  - delayBufferSize;
-    while (dlyPlayPtr < 0) { dlyPlayPtr += delayBufferSize; }
-    
-    delayBuffer.setSize(1, delayBufferSize, true, true, false);
-    delayBuffer.clear();
-    riserBuffer1.setSize(1, riserBufferSize, true, true, false);
-    riserBuffer1.clear();
-    riserBuffer2.setSize(1, riserBufferSize, true, true, false);
-    riserBuffer2.clear();
-    
-    riserSwitch = false;
-    
-    accelerateBase = 1.0f;
-}
-
-float RiserLine::getNextSample(float inputSample, float currentDelayTime, float currentRiserLength, float currentFeedback, float currentAccelerateCap, double currentTempo){
-    
-    feedback = currentFeedback;
-    accelerateCap = currentAccelerateCap;
-    tempo = currentTempo;
-    
-//    update the buffers and do fade-outs to the buffers to avoid clipping
-    setDelayBufferSize(currentDelayTime);
-    setRiserBufferSize(currentRiserLength);
-    delayBuffer.setSize(1, delayBufferSize, true, true, false);
-    delayBuffer.applyGainRamp(floor(delayBufferSize * 0.99), floor(delayBufferSize * 0.01), 1.0f, 0.0f);
-    riserBuffer1.setSize(1, riserBufferSize, true, true, false);
-    riserBuffer1.applyGainRamp(floor(riserBufferSize * 0.99), floor(riserBufferSize * 0.01), 1.0f, 0.0f);
-    riserBuffer2.setSize(1, riserBufferSize, true, true, false);
-    riserBuffer2.applyGainRamp(floor(riserBufferSize * 0.99), floor(riserBufferSize * 0.01), 1.0f, 0.0f);
-    
-//    initiate wetSample for output
-    float wetSample = 0.0f;
-    
-//    when riserSwitched is true, delayBuffer read from riserBuffer1 while input sample from processBlock() being written into riserBuffer2
-    if (riserSwitch) {
-        
-//         write the input sample into riserBuffer2
-        riserBuffer2.setSample(0, riserWritePtr2++, inputSample);
-        
-//        circular delayBuffer needs to circulate the pointer
-        while (dlyPlayPtr < 0)
-            dlyPlayPtr += delayBufferSize-1;
-        
-//        circular delayBuffer needs to circulate the pointers
-        if (dlyWritePtr >= delayBufferSize){
-            dlyWritePtr = 0;
-        }
-        if (dlyPlayPtr >= delayBufferSize-1){ // 'dlyPlayPtr' only goes to 'delayBufferSize-1' due to interpolation
-            dlyPlayPtr = 0;
-        }
-        
-//        interpolate for the fractional delay value between integer samples
-        double a = dlyPlayPtr - (double)floor(dlyPlayPtr);
-        float interplolate = a * delayBuffer.getSample(0, floor(dlyPlayPtr)) + (1-a) * delayBuffer.getSample(0, floor(dlyPlayPtr)+1);
-        
-//        adding the current sample from riserBuffer1 and a delayed sample from the delayBuffer at the delay play pointer
-//        the feedback is larger than 1 so the delayed samples will create a riser effect as they come back from the delayBuffer (the feedback rate is tested to avoid system overload and crash)
-        float feedbackSample = riserBuffer1.getSample(0, riserPlayPtr1++)
-                                                + 0.5 * interplolate * (1 + 0.01*feedback);
-        
-//        put the feedbackSample into the delayBuffer at the current delay write pointer
-        delayBuffer.setSample(0, dlyWritePtr, feedbackSample);
-        
-//        read out the delayed sample from delayBuffer at the delay play pointer.
-        wetSample = delayBuffer.getSample(0, dlyPlayPtr);
-        
-//        since the feedback rate is larger than 1 the output sample is hard clipped at 0.99 to avoid clipping
-        if (wetSample > 0.99)
-            wetSample = 0.99;
-        
-//        move the delay write pointer by 1 and move the delay play pointer by the increment 'accelerateBase'
-        ++dlyWritePtr;
-        dlyPlayPtr+= accelerateBase;
-        
-        // if riserBuffer2 is filled up and riserBuffer1 is read up, the two riserBuffers switch
-        if (riserWritePtr2 >= riserBufferSize and riserPlayPtr1 >= riserBufferSize) {
-//                    riserBuffer.reverse(0, 0, riserBufferSize);
-            
-//            Apply fade-in and fade-out to riserBuffer2
-            riserBuffer2.applyGainRamp(0, riserBufferSize, 0.0f, 1.0f);
-            riserBuffer2.applyGainRamp(floor(riserBufferSize * 0.9), floor(riserBufferSize * 0.1), 1.0f, 0.0f);
-            
-//            change the riserBuffer switch and reset the pointers
-            riserSwitch = false;
-            riserWritePtr2 = 0;
-            dlyPlayPtr = dlyWritePtr - delayBufferSize;
-            riserPlayPtr1 = 0;
-            riserBuffer1.clear();
-            accelerateBase = 1.0f;
-        }
-        
-        // delayBuffer reader pointer increment also increases
-        accelerateBase += ((accelerateCap - 1.0) / riserBufferSize);
-        
-        if (accelerateBase >= accelerateCap){
-            accelerateBase = 1.0f;
-        }
-        
-    }else{ // when riserSwitched is false, delayBuffer read from riserBuffer2 while input sample from processBlock() being written into riserBuffer1
-        
-        // write the input sample into riserBuffer1
-        riserBuffer1.setSample(0, riserWritePtr1++, inputSample);
-        
-        while (dlyPlayPtr < 0)
-            dlyPlayPtr += delayBufferSize-1;
-        
-        if (dlyWritePtr >= delayBufferSize){
-            dlyWritePtr = 0;
-        }
-        if (dlyPlayPtr >= delayBufferSize-1){
-            dlyPlayPtr = 0;
-        }
-        
-        double a = dlyPlayPtr - (double)floor(dlyPlayPtr);
-        float interplolate = a * delayBuffer.getSample(0, floor(dlyPlayPtr)) + (1-a) * delayBuffer.getSample(0, floor(dlyPlayPtr) + 1);
-        
-        float feedbackSample = riserBuffer2.getSample(0, riserPlayPtr2++) + interplolate * feedback;
-        
-        delayBuffer.setSample(0, dlyWritePtr, feedbackSample);
-        
-        wetSample = delayBuffer.getSample(0, dlyPlayPtr);
-        
-        if (wetSample > 0.99)
-            wetSample = 0.99;
-        
-//        move both the delay write pointer and the delay play pointer by 1,
-        ++dlyWritePtr;
-//        ++dlyPlayPtr;
-        dlyPlayPtr+= accelerateBase;
-        
-        // if riserBuffer1 is filled up, the two riserBuffers switch
-        if (riserWritePtr1 >= riserBufferSize and riserPlayPtr2 >= riserBufferSize) {
-//                    riserBuffer.reverse(0, 0, riserBufferSize);
-            
-//            Apply fade-in and fade-out to riserBuffer1
-            riserBuffer1.applyGainRamp(0, riserBufferSize, 0.0f, 1.0f);
-            riserBuffer1.applyGainRamp(floor(riserBufferSize * 0.9), floor(riserBufferSize * 0.1), 1.0f, 0.0f);
-            
-//            Change the riserBuffer switch and reset the pointers
-            riserSwitch = true;
-            riserWritePtr1 = 0;
-            accelerateBase = 1.0f;
-            dlyPlayPtr = dlyWritePtr - delayBufferSize;
-            riserPlayPtr2 = 0;
-            riserBuffer2.clear();
-            accelerateBase = 1.0f;
-        }
-        
-        // delayBuffer reader pointer increment also increases
-        accelerateBase += ((accelerateCap - 1.0) / riserBufferSize);
-        
-        if (accelerateBase >= accelerateCap){
-            accelerateBase = 1.0f;
-        }
-
-    }
-    
-    return wetSample;
-}
-
-void RiserLine::setDelayBufferSize(float newDelayTime) {
-    switch ((int)newDelayTime) {
-        case 1:
-            delayBufferSize = 60 / tempo /8 * sampleRate; // 1/32 note
-            break;
-        case 2:
-            delayBufferSize =  60 / tempo /4 * sampleRate; // 1/16 note
-            break;
-        case 3:
-            delayBufferSize =  60 / tempo /2 * sampleRate; // 1/8 note
-            break;
-        case 4:
-            delayBufferSize =  60 / tempo * sampleRate; // 1/4 note
-            break;
-        case 5:
-            delayBufferSize =  60 / tempo * 2 * sampleRate; // 1/2 note
-            break;
-        case 6:
-            delayBufferSize =  60 / tempo * 4 * sampleRate; // 1 bar
-            break;
-        case 7:
-            delayBufferSize =  60 / tempo * 8 * sampleRate; // 2 bard
-            break;
-            
-        default:
-            delayBufferSize = 60 / tempo * sampleRate;
-            break;
-    }
-}
-
-void RiserLine::setRiserBufferSize(float newRiserLength) {
-    switch ((int)newRiserLength) {
-        case 1:
-            riserBufferSize = 60 / tempo /8 * sampleRate; // 1/32 note
-            break;
-        case 2:
-            riserBufferSize =  60 / tempo /4 * sampleRate; // 1/16 note
-            break;
-        case 3:
-            riserBufferSize =  60 / tempo /2 * sampleRate; // 1/8 note
-            break;
-        case 4:
-            riserBufferSize =  60 / tempo * sampleRate; // 1/4 note
-            break;
-        case 5:
-            riserBufferSize =  60 / tempo * 2 * sampleRate; // 1/2 note
-            break;
-        case 6:
-            riserBufferSize =  60 / tempo * 4 * sampleRate; // 1 bar
-            break;
-        case 7:
-            riserBufferSize =  60 / tempo * 8 * sampleRate; // 2 bard
-            break;
-            
-        default:
-            riserBufferSize = 60 / tempo * sampleRate;
-            break;
-    }
-    
-//    if riserBufferSize is changed the delayBuffer play pointer increment is reset to '1'
-    if (riserBufferSize != riserBuffer1.getNumSamples()){
-        accelerateBase = 1.0f;
-        riserPlayPtr1 = 0;
-        riserWritePtr1 = 0;
-        riserPlayPtr2 = 0;
-        riserWritePtr2 = 0;
-        dlyWritePtr = 0;
-    }
-}
+/*
+  ==============================================================================
+
+    RiserLine.cpp
+    Created: 17 Dec 2023 5:07:49pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RiserLine.h"
+
+namespace
+{
+//    the gain a filled riser cycle is read with: a fade-in across the whole cycle, a fade-out over its last 10%
+//    and silence over the frames that weren't written in the last cycle
+    template <typename SampleType>
+    struct RiserEnvelope
+    {
+        RiserEnvelope(int riserSize, juce::Range<int> skippedFrames)
+            : skipped(skippedFrames),
+              fadeOutStart((int) std::floor(riserSize * 0.9)),
+              fadeInStep((SampleType) 1 / (SampleType) riserSize),
+              fadeOutStep((SampleType) 1 / (SampleType) juce::jmax(1, (int) std::floor(riserSize * 0.1)))
+        {
+        }
+        
+        SampleType getGain(int frame) const noexcept
+        {
+            if (skipped.contains(frame))
+                return 0;
+            
+            const SampleType gain = (SampleType) frame * fadeInStep;
+            
+            if (frame < fadeOutStart)
+                return gain;
+            
+            return gain * juce::jmax((SampleType) 0, (SampleType) 1 - (SampleType) (frame - fadeOutStart) * fadeOutStep);
+        }
+        
+        juce::Range<int> skipped;
+        int fadeOutStart;
+        SampleType fadeInStep;
+        SampleType fadeOutStep;
+    };
+    
+//    a delay read position wrapped round into 0 - bufferSize - 1 the way processFrames() circulates its play pointer
+//    (the interpolation reads the sample after it). The play pointer is left below 0 by a riser switch or while asleep
+//    until its next read wraps it
+    double wrapReadPosition(double position, int bufferSize)
+    {
+        const int wrapLength = juce::jmax(1, bufferSize - 1);
+        
+        while (position < 0)
+            position += wrapLength;
+        
+        return position >= wrapLength ? 0.0 : position;
+    }
+    
+//    the union of the frames already skipped and 'frames' (an empty range isn't allowed to stretch the union down to 0)
+    void addSkippedFrames(juce::Range<int>& skipped, juce::Range<int> frames)
+    {
+        if (! frames.isEmpty())
+            skipped = skipped.isEmpty() ? frames : skipped.getUnionWith(frames);
+    }
+    
+//    lets processFrames() share one body between the scalar mono path and the SIMDRegister path, for float and double
+    template <typename SampleType> struct Lanes
+    {
+        static constexpr int width = 1;
+        static SampleType load(const SampleType* source) noexcept { return *source; }
+        static void store(SampleType* dest, SampleType value) noexcept { *dest = value; }
+        static SampleType peak(SampleType currentPeak, SampleType value) noexcept { return juce::jmax(currentPeak, std::abs(value)); }
+        static float reducePeak(SampleType currentPeak) noexcept { return (float) currentPeak; }
+    };
+    
+    template <typename SampleType> struct Lanes<juce::dsp::SIMDRegister<SampleType>>
+    {
+        using Register = juce::dsp::SIMDRegister<SampleType>;
+        static constexpr int width = (int) Register::SIMDNumElements;
+        static Register load(const SampleType* source) noexcept { return Register::fromRawArray(source); }
+        static void store(SampleType* dest, Register value) noexcept { value.copyToRawArray(dest); }
+        static Register peak(Register currentPeak, Register value) noexcept { return Register::max(currentPeak, Register::abs(value)); }
+        
+        static float reducePeak(Register currentPeak) noexcept
+        {
+            SampleType result = 0;
+            
+            for (size_t lane = 0; lane < Register::SIMDNumElements; ++lane)
+                result = juce::jmax(result, currentPeak.get(lane));
+            
+            return (float) result;
+        }
+    };
+}
+
+template <typename SampleType>
+RiserLine<SampleType>::RiserLine(float delayTime, float riserLength)
+    : currentDelayTime(delayTime), currentRiserLength(riserLength) {
+    
+}
+
+template <typename SampleType>
+RiserLine<SampleType>::~RiserLine(){
+    
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::prepare(float delayTime, float riserLength, float newAccelerateCap, float newFeedback, double newTempo, double newSampleRate, int newNumChannels)
+{
+    accelerateCap = newAccelerateCap;
+    feedback = newFeedback;
+    tempo = juce::jmax(newTempo, minTempo);
+    sampleRate = newSampleRate;
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+    numLanes = FrameBuffer<SampleType>::getNumLanesFor(numChannels);
+    
+//    allocate every buffer once for the longest note length (2 bars) at the slowest tempo so processBlock() never reallocates
+//    (longer bars than 4/4 are capped at this length)
+    maxBufferSize = (int) std::ceil(60 / minTempo * 8 * sampleRate) + 1;
+    inputFrames.setSize(chunkSize, numLanes);
+    outputFrames.setSize(chunkSize, numLanes);
+    compactPlayFrame.setSize(1, numLanes);
+    saturationFrame.setSize(1, numLanes);
+    
+//    under a memory limit, whatever the scratch buffers leave is shared out between the delay frames and the two riser
+//    lengths of the ring
+    const bool compact = riserStorage == RiserStorage::int16;
+    const size_t riserFrameBytes = compact ? (size_t) numChannels * sizeof(juce::int16) : (size_t) numLanes * sizeof(SampleType);
+    const size_t frameBytes = (size_t) numLanes * sizeof(SampleType) + 2 * riserFrameBytes;
+    const size_t scratchBytes = inputFrames.getSizeInBytes() + outputFrames.getSizeInBytes() + compactPlayFrame.getSizeInBytes()
+                              + saturationFrame.getSizeInBytes() + 2 * SIMDRegister::SIMDRegisterSize;
+    
+    memoryLimited = false;
+    
+    if (memoryLimit > 0)
+    {
+        const size_t maxFrames = memoryLimit > scratchBytes ? (memoryLimit - scratchBytes) / frameBytes : 0;
+        memoryLimited = maxFrames < (size_t) maxBufferSize;
+        maxBufferSize = (int) juce::jlimit((size_t) 2, (size_t) maxBufferSize, maxFrames);
+    }
+    
+    delayBuffer.setSize(maxBufferSize, numLanes);
+    riserBuffer.setSize(compact ? 0 : 2 * maxBufferSize, numLanes);
+    compactRiserBuffer.setSize(compact ? 2 * maxBufferSize : 0, numChannels);
+    
+    noteLengths.update(tempo, timeSignature, sampleRate);
+    currentDelayTime = delayTime;
+    currentRiserLength = riserLength;
+    setDelayBufferSize(delayTime);
+    setRiserBufferSize(riserLength);
+    
+    crossfadeLength = juce::jmax(1, (int) (sampleRate * 0.01)); // 10ms
+    maxAlignmentError = crossfadeLength;
+    crossfadeRemaining = 0;
+    
+    riserWritePtr = 0;
+    dlyWritePtr = 0.0;
+    resetRiserPointers();
+    riserWriteSkipped = {};
+    riserReadSkipped = {};
+    
+    wetPeak = 0.0f;
+    numSilentFrames = 0;
+    asleep = false;
+    feedbackSaturation.reset();
+    outputSaturation.reset();
+    
+    dlyPlayPtr = dlyWritePtr  - delayBufferSize;
+    while (dlyPlayPtr < 0) { dlyPlayPtr += delayBufferSize; }
+}
+
+template <typename SampleType>
+size_t RiserLine<SampleType>::getMemoryFootprint() const
+{
+    return delayBuffer.getSizeInBytes() + riserBuffer.getSizeInBytes() + compactRiserBuffer.getSizeInBytes()
+         + compactPlayFrame.getSizeInBytes() + saturationFrame.getSizeInBytes() + inputFrames.getSizeInBytes() + outputFrames.getSizeInBytes();
+}
+
+template <typename SampleType>
+double RiserLine<SampleType>::getTailLengthInSamples() const
+{
+    if (feedback >= 1.0f)
+        return std::numeric_limits<double>::infinity();
+    
+//    the input written into the riser ring is played back into the delay during the following cycle, then every pass
+//    through the delay scales it by the feedback (about 0.5 in the other half of the cycle, so the larger of the two
+//    gives the longest it can take to fall below the silence threshold)
+    const double feedbackGain = juce::jmax((double) feedback, 0.5 * (1.0 + 0.01 * feedback));
+    const double numPasses = std::ceil(std::log((double) silenceThreshold) / std::log(feedbackGain));
+    
+    return 2.0 * riserBufferSize + numPasses * delayBufferSize;
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::updateSleepState(float inputPeak, int numFrames)
+{
+    if (inputPeak >= silenceThreshold || wetPeak >= silenceThreshold)
+        numSilentFrames = 0;
+    else
+        numSilentFrames = juce::jmin(numSilentFrames + numFrames, std::numeric_limits<int>::max() / 2);
+    
+    wetPeak = 0.0f;
+    
+//    by the time both halves of the riser ring have been refilled with silence and a whole pass through the delay has read
+//    nothing audible, there's nothing left that could come back out
+    asleep = numSilentFrames >= 2 * riserBufferSize + delayBufferSize;
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::skipFrames(int numFrames)
+{
+//    carry the riser timing on round the ring as if every frame had been processed
+//    (everything in it is silent, so the skipped frames of the cycles crossed don't matter any more)
+    if (getRiserCyclePosition() + numFrames >= riserBufferSize)
+    {
+        riserWriteSkipped = {};
+        riserReadSkipped = {};
+        numRiserSwitches += (juce::uint32) ((getRiserCyclePosition() + numFrames) / riserBufferSize);
+    }
+    
+    riserWritePtr = (riserWritePtr + numFrames) % (2 * riserBufferSize);
+    
+    accelerateBase = 1.0 + getRiserCyclePosition() * (accelerateCap - 1.0) / riserBufferSize;
+    dlyWritePtr = std::fmod(dlyWritePtr + numFrames, (double) delayBufferSize);
+    dlyPlayPtr = dlyWritePtr - delayBufferSize;
+    crossfadeRemaining = 0;
+    voices.reset(getRiserCyclePosition(), dlyPlayPtr, delayBufferSize);
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::resetRiserPointers(double cyclePosition)
+{
+    double phase = riserPhase + cyclePosition;
+    phase -= std::floor(phase);
+    
+    const int start = juce::jlimit(0, riserBufferSize - 1, (int) (phase * riserBufferSize));
+    
+//    jumping forward leaves frames of the half being written with whatever they held before
+    const int current = getRiserCyclePosition();
+    
+    if (start > current)
+        addSkippedFrames(riserWriteSkipped, { current, start });
+    
+//    the pointer stays in the half it's writing, the read follows it one riser length round the ring
+    riserWritePtr = (riserWritePtr >= riserBufferSize ? riserBufferSize : 0) + start;
+    
+    accelerateBase = 1.0 + start * (accelerateCap - 1.0) / riserBufferSize;
+    voices.reset(start, dlyPlayPtr, delayBufferSize);
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::alignToPosition(double ppqPosition, double ppqPositionOfLastBarStart)
+{
+    const double riserLength = noteLengths.getLengthInQuarterNotes(currentRiserLength);
+    const double barLength = noteLengths.getBarLengthInQuarterNotes();
+    double cyclePosition = 0.0;
+    
+//    a riser cut short to fit the buffers (bars longer than 4/4 at slow tempos, or the memory limit) cycles in fewer
+//    samples than its note length, so it can't follow the bars: lock to its own cycle counted from the start of the
+//    song instead, or the target runs away from the pointers and they're reset every block
+    if (riserBufferSize < noteLengths.getLengthInSamples(currentRiserLength))
+    {
+        const double cycleLength = riserBufferSize * tempo / (60.0 * sampleRate);
+        cyclePosition = std::fmod(ppqPosition, cycleLength) / cycleLength;
+    }
+    else
+    {
+        cyclePosition = getBarCyclePosition(ppqPosition, ppqPositionOfLastBarStart, riserLength, barLength);
+    }
+    
+    if (cyclePosition < 0.0)
+        cyclePosition += 1.0;
+    
+//    compare with where the pointers in use are now, the long way round the cycle counts too
+    double phase = riserPhase + cyclePosition;
+    phase -= std::floor(phase);
+    
+    const int target = (int) (phase * riserBufferSize);
+    const int current = getRiserCyclePosition();
+    const int error = std::abs(current - target);
+    
+    if (juce::jmin(error, riserBufferSize - error) > maxAlignmentError)
+    {
+        resetRiserPointers(cyclePosition);
+        ++numAlignmentResets;
+    }
+}
+
+template <typename SampleType>
+double RiserLine<SampleType>::getBarCyclePosition(double ppqPosition, double ppqPositionOfLastBarStart, double riserLength, double barLength)
+{
+//    count from the last bar line (moved on to the bar this block is actually in), and for risers longer than a bar
+//    add the bars of the riser already gone by
+    double sinceBarStart = ppqPosition - ppqPositionOfLastBarStart;
+    double barStart = ppqPositionOfLastBarStart;
+    
+    while (sinceBarStart >= barLength)
+    {
+        sinceBarStart -= barLength;
+        barStart += barLength;
+    }
+    
+    if (riserLength > barLength)
+    {
+        const int barsPerRiser = juce::roundToInt(riserLength / barLength);
+        const int bar = juce::roundToInt(barStart / barLength);
+        sinceBarStart += ((bar % barsPerRiser + barsPerRiser) % barsPerRiser) * barLength;
+    }
+    
+    return std::fmod(sinceBarStart, riserLength) / riserLength;
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::updateBufferSizes(float newDelayTime, float newRiserLength)
+{
+    const int oldDelayBufferSize = delayBufferSize;
+    const int oldRiserBufferSize = riserBufferSize;
+    const double oldPlayPtr = wrapReadPosition(dlyPlayPtr, delayBufferSize);
+    
+    currentDelayTime = newDelayTime;
+    currentRiserLength = newRiserLength;
+    setDelayBufferSize(newDelayTime);
+    setRiserBufferSize(newRiserLength);
+    
+    if (delayBufferSize == oldDelayBufferSize && riserBufferSize == oldRiserBufferSize)
+        return;
+    
+    ++numBufferResizes;
+    resizeInPlace(delayBuffer, oldDelayBufferSize, delayBufferSize);
+    
+//    keep reading from where the old play pointer was so the jump to the new buffer sizes is crossfaded
+    crossfadePlayPtr = oldPlayPtr;
+    crossfadeDelayBufferSize = oldDelayBufferSize;
+    crossfadeRemaining = crossfadeLength;
+    voices.reset(getRiserCyclePosition(), dlyPlayPtr, delayBufferSize);
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::resizeRiserRing(int oldRiserBufferSize)
+{
+    const bool readingFirstHalf = riserWritePtr >= oldRiserBufferSize;
+    const int written = readingFirstHalf ? riserWritePtr - oldRiserBufferSize : riserWritePtr;
+    
+//    the first half starts the ring whatever the riser length, so when it's the one being read it carries on being read
+//    (anything past its old length is older audio). The second half moves with the riser length, so instead the
+//    read switches over to what this cycle has written into the first half so far
+    if (readingFirstHalf)
+    {
+        addSkippedFrames(riserReadSkipped, { oldRiserBufferSize, juce::jmax(oldRiserBufferSize, riserBufferSize) });
+    }
+    else
+    {
+        riserReadSkipped = riserWriteSkipped;
+        addSkippedFrames(riserReadSkipped, { juce::jmin(written, riserBufferSize), riserBufferSize });
+    }
+    
+//    either way the second half is written next, from scratch
+    riserWriteSkipped = {};
+    riserWritePtr = riserBufferSize;
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::resizeInPlace(FrameBuffer<SampleType>& buffer, int oldSize, int newSize)
+{
+    if (newSize > oldSize)
+        buffer.clear(oldSize, newSize - oldSize);
+    
+    buffer.applyGainRamp(floor(newSize * 0.99), floor(newSize * 0.01), 1.0f, 0.0f);
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::processBlock(const SampleType* input, SampleType* output, int numSamples, const Params& params){
+    processBlock(&input, &output, 1, numSamples, params);
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::processBlock(const SampleType* const* input, SampleType* const* output, int numChannelsToProcess, int numSamples, const Params& params){
+    
+    feedback = params.feedback;
+    accelerateCap = params.accelerateCap;
+    
+//    the buffer sizes only need recomputing when the note lengths, the tempo or the time signature actually change
+    tempo = juce::jmax(params.tempo, minTempo);
+    timeSignature = params.timeSignature;
+    
+    if (noteLengths.update(tempo, timeSignature, sampleRate) || params.delayTime != currentDelayTime || params.riserLength != currentRiserLength)
+        updateBufferSizes(params.delayTime, params.riserLength);
+    
+//    below minTempo the buffers run slower than the host, so there's nothing to lock to
+    if (params.hasPosition && params.tempo >= minTempo)
+        alignToPosition(params.ppqPosition, params.ppqPositionOfLastBarStart);
+    
+//    the voices take the accelerateCap of the block, and start over when their number or the riser length changes
+    if (voices.configure(params.numVoices, params.voiceSpread, params.accelerateCap, riserBufferSize))
+        voices.reset(getRiserCyclePosition(), dlyPlayPtr, delayBufferSize);
+    
+    feedbackSaturation.setCurve(params.saturation, params.antialiasing);
+    outputSaturation.setCurve(params.saturation, params.antialiasing);
+    
+    const Ramps ramps { { params.feedbackRamp, params.feedback },
+                        { params.accelerateCapRamp, params.accelerateCap },
+                        { params.wetDryRatioRamp, params.wetDryRatio } };
+    
+    jassert(numChannelsToProcess <= numChannels);
+    numChannelsToProcess = juce::jmin(numChannelsToProcess, numChannels);
+    
+    float inputPeak = 0.0f;
+    
+    for (int channel = 0; channel < numChannelsToProcess; ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(input[channel], numSamples);
+        inputPeak = juce::jmax(inputPeak, (float) -range.getStart(), (float) range.getEnd());
+    }
+    
+//    asleep, the output is just the dry input until some input comes back
+    if (asleep && inputPeak < silenceThreshold)
+    {
+        skipFrames(numSamples);
+        
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            if (ramps.wetDryRatio.isConstant())
+            {
+                juce::FloatVectorOperations::multiply(output[channel], input[channel], (SampleType) (1.0f - ramps.wetDryRatio.value), numSamples);
+                continue;
+            }
+            
+            for (int i = 0; i < numSamples; ++i)
+                output[channel][i] = input[channel][i] * (SampleType) (1.0f - ramps.wetDryRatio[i]);
+        }
+        
+        return;
+    }
+    
+    asleep = false;
+    
+//    mono runs straight on the host buffer
+    if (numLanes == 1)
+    {
+        processFrames<SampleType>(params.interpolation, input[0], output[0], numSamples, ramps);
+        updateSleepState(inputPeak, numSamples);
+        return;
+    }
+    
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int numFrames = juce::jmin(chunkSize, numSamples - start);
+        
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            const SampleType* source = input[channel] + start;
+            
+            for (int i = 0; i < numFrames; ++i)
+                inputFrames.getFrame(i)[channel] = source[i];
+        }
+        
+        processFrames<SIMDRegister>(params.interpolation, inputFrames.getFrame(0), outputFrames.getFrame(0), numFrames, ramps.withOffset(start));
+        
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            SampleType* dest = output[channel] + start;
+            
+            for (int i = 0; i < numFrames; ++i)
+                dest[i] = outputFrames.getFrame(i)[channel];
+        }
+    }
+    
+    updateSleepState(inputPeak, numSamples);
+}
+
+template <typename SampleType>
+int RiserLine<SampleType>::getKernelRunLength(double writePtr, double playPtr, double base, double baseIncrement, int riserPtr, int numFramesLeft)
+{
+    const int dlySize = delayBufferSize;
+    
+    if (playPtr < 0 || playPtr >= dlySize - 1 || writePtr >= dlySize)
+        return 0;
+    
+//    stop before the delay write pointer wraps, the riser cycle ends or accelerateBase reaches the cap
+    int runLength = juce::jmin(numFramesLeft, ReadHeadKernel::maxRunLength, dlySize - (int) writePtr, riserBufferSize - riserPtr - 1);
+    
+    if (baseIncrement > 0.0)
+        runLength = juce::jmin(runLength, (int) ((accelerateCap - base) / baseIncrement) - 1);
+    
+    if (runLength < minKernelRunLength)
+        return 0;
+    
+//    ...and before the play pointer wraps. Both this and the check below only need the first and last positions, which
+//    come from their closed form, so the positions are only filled for a run that's actually used
+    runLength = ReadHeadKernel::countPositionsBelow(dlySize - 1, runLength, playPtr, base, baseIncrement);
+    
+    if (runLength < minKernelRunLength)
+        return 0;
+    
+//    every read has to come from samples written before the run, since the whole run is gathered before anything is written
+    const int firstWrite = (int) writePtr;
+    const int firstRead = (int) playPtr;
+    const int lastRead = (int) ReadHeadKernel::getPosition(runLength - 1, playPtr, base, baseIncrement) + 1;
+    
+    if (lastRead >= firstWrite && firstRead < firstWrite + runLength)
+        return 0;
+    
+    ReadHeadKernel::fillPositions(runPositions.data(), runLength + 1, playPtr, base, baseIncrement);
+    return runLength;
+}
+
+template <typename SampleType>
+template <typename LaneType>
+void RiserLine<SampleType>::processFrames(Interpolation::Quality quality, const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps)
+{
+    if (riserStorage == RiserStorage::int16)
+        processFrames<LaneType, RiserStorage::int16>(quality, input, output, numFrames, ramps);
+    else
+        processFrames<LaneType, RiserStorage::float32>(quality, input, output, numFrames, ramps);
+}
+
+template <typename SampleType>
+template <typename LaneType, RiserLineBase::RiserStorage storage>
+void RiserLine<SampleType>::processFrames(Interpolation::Quality quality, const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps)
+{
+    switch (quality)
+    {
+        case Interpolation::Quality::hermite:
+            processFrames<LaneType, Interpolation::hermiteTaps, storage>(input, output, numFrames, ramps);
+            break;
+        case Interpolation::Quality::sinc:
+            processFrames<LaneType, Interpolation::sincTaps, storage>(input, output, numFrames, ramps);
+            break;
+            
+        case Interpolation::Quality::linear:
+        default:
+            processFrames<LaneType, Interpolation::linearTaps, storage>(input, output, numFrames, ramps);
+            break;
+    }
+}
+
+template <typename SampleType>
+template <int numTaps>
+const SampleType* RiserLine<SampleType>::getReadTaps(double position, double speed, int* indices, SampleType* weightStorage) const
+{
+    const int index = (int) position;
+    const SampleType fraction = (SampleType) (position - index);
+    const SampleType* weights = weightStorage;
+    
+    if constexpr (numTaps == Interpolation::linearTaps)
+    {
+        Interpolation::getLinearWeights(fraction, weightStorage);
+    }
+    else if constexpr (numTaps == Interpolation::hermiteTaps)
+    {
+        Interpolation::getHermiteWeights(fraction, weightStorage);
+    }
+    else
+    {
+//        the sinc table is float, double takes a copy of the row
+        const float* tableWeights = sincTable.getWeights(Interpolation::SincTable::getBandForSpeed(speed), (float) fraction);
+        
+        if constexpr (std::is_same<SampleType, float>::value)
+            weights = tableWeights;
+        else
+            std::copy(tableWeights, tableWeights + numTaps, weightStorage);
+    }
+    
+//    the taps wrap around the circular delayBuffer
+    for (int tap = 0; tap < numTaps; ++tap)
+    {
+        int tapIndex = index + Interpolation::getFirstTapOffset(numTaps) + tap;
+        
+        if (tapIndex < 0)
+            tapIndex += delayBufferSize;
+        else if (tapIndex >= delayBufferSize)
+            tapIndex -= delayBufferSize;
+        
+        indices[tap] = tapIndex;
+    }
+    
+    return weights;
+}
+
+template <typename SampleType>
+template <typename LaneType, int numTaps, RiserLineBase::RiserStorage storage>
+void RiserLine<SampleType>::processFrames(const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps){
+    
+    using L = Lanes<LaneType>;
+    
+//    the state below is copied into locals for the duration of the block and written back at the end
+    const int lanes = numLanes;
+    SampleType* delayData = delayBuffer.getFrame(0);
+    
+    double writePtr = dlyWritePtr;
+    double playPtr = dlyPlayPtr;
+    double base = accelerateBase;
+    const int dlySize = delayBufferSize;
+    const int riserSize = riserBufferSize;
+    
+//    delayBuffer reads the riser ring one riser length round from where the input is written, 'riserPtr' counts
+//    the frames into the current cycle for both of them
+    SampleType* riserData = riserBuffer.getFrame(0);
+    int riserWrite = riserWritePtr;
+    int riserPlay = riserWrite >= riserSize ? riserWrite - riserSize : riserWrite + riserSize;
+    int riserPtr = getRiserCyclePosition();
+    bool readingFirstHalf = riserPlay < riserSize;
+    const SampleType crossfadeStep = (SampleType) 1 / crossfadeLength;
+    const double constantBaseIncrement = (ramps.accelerateCap.value - 1.0) / riserSize;
+    RiserEnvelope<SampleType> envelope(riserSize, riserReadSkipped);
+    auto peak = LaneType();
+    
+    const int numExtraVoices = voices.getNumExtraVoices();
+    const SampleType voiceMixGain = voices.getMixGain();
+    const bool antialiasing = outputSaturation.isAntialiased();
+    int voiceIndices[RiserVoices::maxVoices];
+    SampleType voiceFractions[RiserVoices::maxVoices];
+    
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const float frameFeedback = ramps.feedback[i];
+        const float cap = ramps.accelerateCap[i];
+        const SampleType wetGain = ramps.wetDryRatio[i];
+        const SampleType dryGain = (SampleType) 1 - wetGain;
+        const double baseIncrement = ramps.accelerateCap.isConstant() ? constantBaseIncrement : (cap - 1.0) / riserSize;
+        
+//        the feedback alternates with the halves of the riser ring so the delayed samples will create a riser effect as they come back
+//        from the delayBuffer (the feedback rate is tested to avoid system overload and crash)
+        const SampleType feedbackScale = readingFirstHalf ? (SampleType) 0.005 : (SampleType) 1;
+        const SampleType feedbackOffset = readingFirstHalf ? (SampleType) 0.5 : (SampleType) 0;
+        const SampleType feedbackGain = feedbackOffset + feedbackScale * frameFeedback;
+        
+//        on the mono linear path, stretches where nothing wraps around or resets go through the vectorised read-head kernel
+//        (which needs a fixed read speed increment, so not while accelerateCap is ramping, and only reads for one voice)
+        if constexpr (std::is_same<LaneType, float>::value && numTaps == Interpolation::linearTaps)
+        {
+            const bool kernelAllowed = crossfadeRemaining == 0 && ramps.accelerateCap.isConstant() && numExtraVoices == 0;
+            const int runLength = kernelAllowed ? getKernelRunLength(writePtr, playPtr, base, baseIncrement, riserPtr, numFrames - i) : 0;
+            
+            if (runLength > 0)
+            {
+                const float* runInput = input + i;
+                float* runOutput = output + i;
+                float* delayWrite = delayData + (int) writePtr;
+                
+                gather(delayData, runPositions.data(), runInterpolated.data(), runLength);
+                
+                if constexpr (storage == RiserStorage::int16)
+                {
+                    compactRiserBuffer.write(riserWrite, runInput, runLength);
+                    
+                    for (int frame = 0; frame < runLength; ++frame)
+                        delayWrite[frame] = compactRiserBuffer.getSample(riserPlay + frame, 0) * envelope.getGain(riserPtr + frame);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::copy(riserData + riserWrite, runInput, runLength);
+                    
+                    for (int frame = 0; frame < runLength; ++frame)
+                        delayWrite[frame] = riserData[riserPlay + frame] * envelope.getGain(riserPtr + frame);
+                }
+                
+//                runs never cross a riser switch, so the feedback gain only follows the feedback ramp
+                if (ramps.feedback.isConstant())
+                {
+                    juce::FloatVectorOperations::addWithMultiply(delayWrite, runInterpolated.data(), feedbackGain, runLength);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::multiply(runGains.data(), ramps.feedback.values + i, feedbackScale, runLength);
+                    juce::FloatVectorOperations::add(runGains.data(), feedbackOffset, runLength);
+                    
+                    juce::FloatVectorOperations::addWithMultiply(delayWrite, runInterpolated.data(), runGains.data(), runLength);
+                }
+                
+                feedbackSaturation.processRun(delayWrite, delayWrite, runLength);
+                
+                const auto runRange = juce::FloatVectorOperations::findMinAndMax(runInterpolated.data(), runLength);
+                peak = juce::jmax(peak, -runRange.getStart(), runRange.getEnd());
+                
+                outputSaturation.processRun(runInterpolated.data(), runInterpolated.data(), runLength);
+                
+                if (ramps.wetDryRatio.isConstant())
+                {
+                    juce::FloatVectorOperations::multiply(runOutput, runInput, dryGain, runLength);
+                    juce::FloatVectorOperations::addWithMultiply(runOutput, runInterpolated.data(), wetGain, runLength);
+                }
+                else
+                {
+//                    input + (wet - input) * ratio, written last since 'runOutput' may be 'runInput'
+                    juce::FloatVectorOperations::subtract(runInterpolated.data(), runInterpolated.data(), runInput, runLength);
+                    juce::FloatVectorOperations::multiply(runInterpolated.data(), ramps.wetDryRatio.values + i, runLength);
+                    juce::FloatVectorOperations::add(runOutput, runInput, runInterpolated.data(), runLength);
+                }
+                
+                writePtr += runLength;
+                playPtr = runPositions[(size_t) runLength];
+                base += runLength * baseIncrement;
+                riserWrite += runLength;
+                riserPlay += runLength;
+                riserPtr += runLength;
+                
+                i += runLength - 1;
+                continue;
+            }
+        }
+        
+//        circular delayBuffer needs to circulate the pointers
+        while (playPtr < 0)
+            playPtr += dlySize - 1;
+        
+        if (writePtr >= dlySize)
+            writePtr = 0;
+        
+        if (playPtr >= dlySize - 1) // 'playPtr' only goes to 'delayBufferSize-1' due to interpolation
+            playPtr = 0;
+        
+        int tapIndices[numTaps];
+        SampleType tapWeightStorage[numTaps];
+        const SampleType* tapWeights = getReadTaps<numTaps>(playPtr, base, tapIndices, tapWeightStorage);
+        
+        const SampleType* inputFrame = input + (size_t) i * (size_t) lanes;
+        SampleType* outputFrame = output + (size_t) i * (size_t) lanes;
+        SampleType* riserWriteFrame = nullptr;
+        const SampleType* riserPlayFrame = compactPlayFrame.getFrame(0);
+        const SampleType riserGain = envelope.getGain(riserPtr++);
+        
+//        the compact ring is converted a frame at a time, the input straight from 'inputFrame'
+        if constexpr (storage == RiserStorage::int16)
+        {
+            compactRiserBuffer.writeFrame(riserWrite++, inputFrame);
+            compactRiserBuffer.readFrame(riserPlay++, compactPlayFrame.getFrame(0));
+        }
+        else
+        {
+            riserWriteFrame = riserData + (size_t) riserWrite++ * (size_t) lanes;
+            riserPlayFrame = riserData + (size_t) riserPlay++ * (size_t) lanes;
+        }
+        
+        if (numExtraVoices > 0)
+            voices.getReadTaps(voiceIndices, voiceFractions);
+        
+        SampleType* delayWriteFrame = delayData + (size_t) writePtr * (size_t) lanes;
+        
+//        while a resize crossfade is running, fade out the old play pointer against the new one
+        const bool crossfading = crossfadeRemaining > 0;
+        const SampleType crossfadeGain = crossfadeRemaining * crossfadeStep;
+        const SampleType* crossfadeFrame = delayData + (size_t) crossfadePlayPtr * (size_t) lanes;
+        SampleType* wetFrame = saturationFrame.getFrame(0);
+        
+        for (int lane = 0; lane < lanes; lane += L::width)
+        {
+            const auto inputSample = L::load(inputFrame + lane);
+            
+//            write the input sample into the half of the riser ring being filled
+            if constexpr (storage == RiserStorage::float32)
+                L::store(riserWriteFrame + lane, inputSample);
+            
+//            interpolate for the fractional delay value between integer samples
+            auto interpolate = L::load(delayData + (size_t) tapIndices[0] * (size_t) lanes + lane) * tapWeights[0];
+            
+            for (int tap = 1; tap < numTaps; ++tap)
+                interpolate = interpolate + L::load(delayData + (size_t) tapIndices[tap] * (size_t) lanes + lane) * tapWeights[tap];
+            
+//            the extra voices read linearly interpolated, before this frame's write, and are mixed in with the main read
+            auto wet = interpolate;
+            
+            if (numExtraVoices > 0)
+            {
+                for (int voice = 0; voice < numExtraVoices; ++voice)
+                {
+                    const SampleType* first = delayData + (size_t) voiceIndices[voice] * (size_t) lanes + lane;
+                    const auto firstSample = L::load(first);
+                    wet = wet + firstSample + (L::load(first + lanes) - firstSample) * voiceFractions[voice];
+                }
+                
+                wet = wet * voiceMixGain;
+            }
+            
+//            add the current sample from the half being read and the delayed sample, then put it into the delayBuffer
+//            through the feedback saturation so the loop can't build up
+            const auto delayed = L::load(riserPlayFrame + lane) * riserGain + interpolate * feedbackGain;
+            
+//            the delayed sample (with the voices) is the output, saturated too since the feedback rate can be larger than 1
+            peak = L::peak(peak, interpolate);
+            
+            if (crossfading)
+                wet = wet + (L::load(crossfadeFrame + lane) - wet) * crossfadeGain;
+            
+//            without antialiasing the curve works on the lanes as they are. With it every lane carries on from its previous
+//            sample, so mono goes through the stage a sample at a time and a wider frame once all of its lanes are in memory
+            if (! antialiasing)
+            {
+                L::store(delayWriteFrame + lane, feedbackSaturation.apply(delayed));
+                L::store(outputFrame + lane, outputSaturation.apply(wet) * wetGain + inputSample * dryGain);
+            }
+            else if constexpr (L::width == 1)
+            {
+                L::store(delayWriteFrame, feedbackSaturation.processSample(delayed, 0));
+                L::store(outputFrame, outputSaturation.processSample(wet, 0) * wetGain + inputSample * dryGain);
+            }
+            else
+            {
+                L::store(delayWriteFrame + lane, delayed);
+                L::store(wetFrame + lane, wet);
+            }
+        }
+        
+        if (L::width > 1 && antialiasing)
+        {
+            feedbackSaturation.processLanes(delayWriteFrame, 0, lanes);
+            outputSaturation.processLanes(wetFrame, 0, lanes);
+            
+            for (int lane = 0; lane < lanes; lane += L::width)
+                L::store(outputFrame + lane, L::load(wetFrame + lane) * wetGain + L::load(inputFrame + lane) * dryGain);
+        }
+        
+        if (crossfading)
+        {
+            --crossfadeRemaining;
+            crossfadePlayPtr = wrapReadPosition(crossfadePlayPtr + base, crossfadeDelayBufferSize);
+        }
+        
+//        move the delay write pointer by 1 and move the delay play pointer by the increment 'base'
+        ++writePtr;
+        playPtr += base;
+        
+//        once a whole cycle is written, both pointers carry on into the other one's half: the read into the cycle just filled
+//        (which gets its fades through 'envelope' as it's read), the write over the one just read up (each wraps round at the end of the ring)
+        if (riserPtr >= riserSize)
+        {
+            riserReadSkipped = riserWriteSkipped;
+            riserWriteSkipped = {};
+            envelope.skipped = riserReadSkipped;
+            
+            const int filledEnd = riserWrite;
+            riserWrite = riserPlay - riserSize;
+            riserPlay = filledEnd - riserSize;
+            riserPtr = 0;
+            readingFirstHalf = ! readingFirstHalf;
+            playPtr = writePtr - dlySize;
+            base = 1.0;
+            ++numRiserSwitches;
+        }
+        
+//        delayBuffer reader pointer increment also increases
+        base += baseIncrement;
+        
+        if (base >= cap)
+            base = 1.0;
+        
+        if (numExtraVoices > 0)
+            voices.advance(riserPtr, writePtr - dlySize, dlySize);
+    }
+    
+    dlyWritePtr = writePtr;
+    dlyPlayPtr = playPtr;
+    accelerateBase = base;
+    wetPeak = juce::jmax(wetPeak, L::reducePeak(peak));
+    riserWritePtr = riserWrite;
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::setDelayBufferSize(float newDelayTime) {
+    delayBufferSize = juce::jlimit(2, juce::jmax(2, maxBufferSize), noteLengths.getLengthInSamples(newDelayTime));
+}
+
+template <typename SampleType>
+void RiserLine<SampleType>::setRiserBufferSize(float newRiserLength) {
+    const int oldRiserBufferSize = riserBufferSize;
+    
+    riserBufferSize = juce::jlimit(1, juce::jmax(1, maxBufferSize), noteLengths.getLengthInSamples(newRiserLength));
+    
+//    if riserBufferSize is changed the delayBuffer play pointer increment is reset to '1'
+    if (riserBufferSize != oldRiserBufferSize){
+        resizeRiserRing(oldRiserBufferSize);
+        resetRiserPointers();
+        dlyWritePtr = 0;
+    }
+}
+
+template class RiserLine<float>;
+template class RiserLine<double>;
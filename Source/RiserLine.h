@@ -1,65 +1,316 @@
-/*
-  ==============================================================================
-
-    RiserLine.h
-    Created: 17 Dec 2023 5:07:38pm
-    Author:  Zi Meng
-
-  ==============================================================================
-*/
-
-#pragma once
-#include <JuceHeader.h>
-
-class RiserLine
-{
-public:
-    RiserLine(float delayTime, float riserLength);
-    ~RiserLine();
-    
-    // set up the parameters
-    void prepare(float delayTime, float riserLength, float accelerateCap, float feedbak, double tempo, double sampleRate);
-    
-    // take in a new sample and return a delayed sample
-    float getNextSample(float inputSample, float currentDelayTime, float currentRiserLength, float currentFeedback, float currentAccelerateCap, double currentTempo);
-    
-    // convert delayTime indices ('1' - '5' corresponding to 1/32, 1/16, 1/8, 1/4, 1/2 notes) to delaybuffer size in samples
-    void setDelayBufferSize(float newDelayTime);
-    
-    // convert riserLength indices ('3' - '7' corresponding to 1/8, 1/4, 1/2, 1, 2 notes) to riserbuffer size in samples
-    void setRiserBufferSize(float newRiserLength);
-    
-private:
-    
-    juce::AudioBuffer<float> delayBuffer; // the delay line
-    
-//     delaybBuffer reads from the 2 riserbuffers alternatively (delayBuffer reads from one riserBuffer while the input sample from processBlock() is written into the other).
-//    Since both riserbuffers are of same length,
-//    when one is finished writing the other will be finished reading then the roles switch.
-    juce::AudioBuffer<float> riserBuffer1;
-    juce::AudioBuffer<float> riserBuffer2;
-    
-    int sampleRate;
-    float feedback;
-    
-    int delayBufferSize; // in samples
-    int riserBufferSize; // in samples
-    
-//    the step delayBuffer uses to read out next delay sample and the step increases from 1 to accelerateCap 
-//    as delayBuffer reads out delay samples.
-    float accelerateBase = 1.0f;
-    
-//     the largest step delayBuffer uses to read out next delay sample
-//    ( '2' means reading out at twice the speed of the original signal which is also one octave higher)
-    float accelerateCap = 2.0f;
-    
-    bool riserSwitch = false; //switch between riserBuffer1 and riserBuffer2
-
-    double dlyWritePtr = 0; // the pointer where input signal(from the riserBuffers) is written into delayBuffer
-    double dlyPlayPtr = 0; // the pointer where the output reads from delayBuffer
-    int riserWritePtr1 = 0; // the pointer where input signal(from the processBlock()) is written into riserWritePtr1
-    int riserPlayPtr1 = 0; // the pointer where the delayBuffer reads from riserWritePtr1
-    int riserWritePtr2 = 0; // the pointer where input signal(from the processBlock()) is written into riserWritePtr2
-    int riserPlayPtr2 = 0; // the pointer where the delayBuffer reads from riserWritePtr2
-    double tempo = 120; // the BPM from the host (default value 120)
-};
+/*
+  ==============================================================================
+
+    RiserLine.h
+    Created: 17 Dec 2023 5:07:38pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "FrameBuffer.h"
+#include "CompactFrameBuffer.h"
+#include "RiserVoices.h"
+#include "Saturation.h"
+#include "ReadHeadKernel.h"
+#include "Interpolation.h"
+#include "TempoEngine.h"
+#include "SharedTables.h"
+
+// The parts of RiserLine that don't depend on the sample type it runs at, the same for RiserLine<float> and RiserLine<double>
+class RiserLineBase
+{
+public:
+    // the parameters processBlock() reads once at the start of every block
+    struct Params
+    {
+        float delayTime = 3.0f;
+        float riserLength = 5.0f;
+        float feedback = 0.3f;
+        float accelerateCap = 2.0f;
+        float wetDryRatio = 0.5f;
+        double tempo = 120.0;
+        juce::AudioPlayHead::TimeSignature timeSignature;
+        Interpolation::Quality interpolation = Interpolation::Quality::linear;
+        
+        // the riser voices (1 - RiserVoices::maxVoices) staggered over the riser cycle, and how far their
+        // accelerateCaps spread around 'accelerateCap' (0 - 1). See RiserVoices
+        int numVoices = 1;
+        float voiceSpread = 0.5f;
+        
+        // the curve the feedback loop and the output are saturated with, and whether it's antialiased. See Saturation
+        Saturation::Curve saturation = Saturation::Curve::hardClip;
+        bool antialiasing = false;
+        
+        // where the host transport is at the start of the block, when it's playing. The riser cycles are kept
+        // locked to it so they start on the bar lines, even after the transport jumps
+        bool hasPosition = false;
+        double ppqPosition = 0.0;
+        double ppqPositionOfLastBarStart = 0.0;
+        
+        // optional per-sample values for the smoothed parameters, one for every sample of the block.
+        // while a ramp is set it's followed instead of the value above, which should be the ramp's last value
+        const float* feedbackRamp = nullptr;
+        const float* accelerateCapRamp = nullptr;
+        const float* wetDryRatioRamp = nullptr;
+    };
+    
+    // host tempos below this are clamped so the preallocated buffers always hold the longest note length (2 bars)
+    static constexpr double minTempo = 40.0;
+    
+    static constexpr int maxChannels = 8;
+    
+    // how the riser ring holds its samples: float32 as they are, int16 as dithered 16-bit integers with 6dB of headroom
+    // (a quarter of the riser memory for stereo, the output ends up about 80dB above the difference). Takes effect on prepare()
+    enum class RiserStorage
+    {
+        float32,
+        int16
+    };
+    
+    static constexpr float silenceThreshold = 1.0e-5f; // -100dB
+};
+
+// 'SampleType' is float or double, and everything the signal goes through runs at it: the delay and riser buffers, the
+// interpolation and the saturation. Both are compiled in RiserLine.cpp, so each is specialised with no runtime dispatch
+template <typename SampleType>
+class RiserLine  : public RiserLineBase
+{
+public:
+    // allocates nothing, the buffers are made by prepare() once the memory limit and riser storage are set
+    RiserLine(float delayTime, float riserLength);
+    ~RiserLine();
+    
+    // set up the parameters and preallocate the buffers for the largest note length at 'minTempo' and this sample rate.
+    // every channel gets its own delay and riser signal but they all share the riser timing and run through the same loop
+    // as the lanes of a SIMDRegister
+    void prepare(float delayTime, float riserLength, float accelerateCap, float feedbak, double tempo, double sampleRate, int numChannels = 1);
+    
+    // take in a block of input samples and write the wet/dry mixed riser signal to 'output'
+    // ('input' and 'output' may point to the same memory)
+    void processBlock(const SampleType* input, SampleType* output, int numSamples, const Params& params);
+    
+    // the same for up to the number of channels passed to prepare()
+    void processBlock(const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples, const Params& params);
+    
+    // start every riser cycle 'newPhase' (0 - 1) of a riser length in, so unlinked channels can be staggered (takes effect on prepare())
+    void setRiserPhase(float newPhase) { riserPhase = newPhase; }
+    
+    // convert delayTime indices ('1' - '5' corresponding to 1/32, 1/16, 1/8, 1/4, 1/2 notes) to delaybuffer size in samples
+    void setDelayBufferSize(float newDelayTime);
+    
+    // convert riserLength indices ('3' - '7' corresponding to 1/8, 1/4, 1/2 notes, 1 and 2 bars) to riserbuffer size in samples
+    void setRiserBufferSize(float newRiserLength);
+    
+    // the bytes held by the delay, riser and scratch buffers
+    size_t getMemoryFootprint() const;
+    
+    // the gather the read-head kernel interpolates its runs with, the fastest this CPU supports unless RiseUpRender
+    // picks one of ReadHeadKernel::getSupportedGathers() to time or check it
+    void setGatherFunction(ReadHeadKernel::GatherFunction newGather) { gather = newGather; }
+    
+    // see RiserStorage
+    void setRiserStorage(RiserStorage newStorage) { riserStorage = newStorage; }
+    RiserStorage getRiserStorage() const noexcept { return riserStorage; }
+    
+    // the most memory prepare() may allocate, 0 for no limit. When the longest note lengths at 'minTempo' don't fit,
+    // the buffers are made as long as the limit allows and longer note lengths are cut short to them
+    void setMemoryLimit(size_t maxBytes) { memoryLimit = maxBytes; }
+    
+    // true when the memory limit cut the buffers shorter than the longest note length at 'minTempo'
+    bool isMemoryLimited() const noexcept { return memoryLimited; }
+    
+    // how long the output can carry on after the input goes silent at the current feedback and note lengths
+    // (infinite at a feedback of 1)
+    double getTailLengthInSamples() const;
+    
+    // true while the input and everything in the buffers have been below 'silenceThreshold' for long enough
+    // that processBlock() skips the riser altogether
+    bool isAsleep() const noexcept { return asleep; }
+    
+    // where the riser is, for the editor's telemetry: how far into the riser cycle the write pointer is (0 - 1),
+    // the speed the delay is read at (the pitch ratio, from 1 up to accelerateCap) and how many cycles have finished
+    float getRiserProgress() const noexcept { return riserBufferSize > 0 ? (float) getRiserCyclePosition() / (float) riserBufferSize : 0.0f; }
+    double getPlaybackSpeed() const noexcept { return accelerateBase; }
+    juce::uint32 getNumRiserSwitches() const noexcept { return numRiserSwitches; }
+    
+    // how many times the buffer sizes have changed for a note length or tempo change, for the load meter
+    juce::uint32 getNumBufferResizes() const noexcept { return numBufferResizes; }
+    
+    // how many times the riser pointers have been moved to follow the host position
+    juce::uint32 getNumAlignmentResets() const noexcept { return numAlignmentResets; }
+    
+    // where in the delay buffer the old read of a resize crossfade is, -1 while none is running (for RiseUpRender's checks)
+    double getCrossfadeReadPosition() const noexcept { return crossfadeRemaining > 0 ? crossfadePlayPtr : -1.0; }
+    
+private:
+    
+    // the number of frames interleaved and processed at a time when there's more than one lane
+    static constexpr int chunkSize = 64;
+    
+    // a smoothed parameter over the frames being processed, 'values' is null while it holds still at 'value'
+    struct Ramp
+    {
+        const float* values = nullptr;
+        float value = 0.0f;
+        
+        bool isConstant() const noexcept { return values == nullptr; }
+        float operator[](int frame) const noexcept { return values != nullptr ? values[frame] : value; }
+        Ramp withOffset(int offset) const noexcept { return { values != nullptr ? values + offset : nullptr, value }; }
+    };
+    
+    struct Ramps
+    {
+        Ramp feedback;
+        Ramp accelerateCap;
+        Ramp wetDryRatio;
+        
+        Ramps withOffset(int offset) const noexcept { return { feedback.withOffset(offset), accelerateCap.withOffset(offset), wetDryRatio.withOffset(offset) }; }
+    };
+    
+    using SIMDRegister = typename FrameBuffer<SampleType>::SIMDRegister;
+    
+    // run the riser over interleaved frames, 'LaneType' is SampleType for mono and a SIMDRegister of it for multichannel,
+    // 'numTaps' the number of taps the delay read is interpolated from and 'storage' which riser ring is used
+    template <typename LaneType, int numTaps, RiserStorage storage>
+    void processFrames(const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps);
+    
+    // pick the processFrames() for the interpolation quality and the riser storage
+    template <typename LaneType, RiserStorage storage>
+    void processFrames(Interpolation::Quality quality, const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps);
+    
+    template <typename LaneType>
+    void processFrames(Interpolation::Quality quality, const SampleType* input, SampleType* output, int numFrames, const Ramps& ramps);
+    
+    // the delayBuffer indices (wrapped around 'delayBufferSize') and weights of the taps the read at 'position' is interpolated from
+    template <int numTaps>
+    const SampleType* getReadTaps(double position, double speed, int* indices, SampleType* weightStorage) const;
+    
+    // the number of mono samples from here that the read-head kernel can do in one run (0 if the next sample needs the scalar loop),
+    // leaves the read positions of the run and the one after it in 'runPositions'
+    int getKernelRunLength(double writePtr, double playPtr, double base, double baseIncrement, int riserPtr, int numFramesLeft);
+    
+    // shorter runs aren't worth setting up
+    static constexpr int minKernelRunLength = 8;
+    
+    // move the pointers on by 'numFrames' without reading or writing the buffers, while asleep
+    void skipFrames(int numFrames);
+    
+    // fall asleep once input and wet signal have been silent for long enough
+    void updateSleepState(float inputPeak, int numFrames);
+    
+    // move the riser pointers to 'cyclePosition' (0 - 1) of a riser cycle, offset by 'riserPhase'
+    void resetRiserPointers(double cyclePosition = 0.0);
+    
+    // lay the riser ring out again for a new riserBufferSize, keeping whatever the next cycle can still read back
+    void resizeRiserRing(int oldRiserBufferSize);
+    
+    // how far into the current riser cycle the write pointer is
+    int getRiserCyclePosition() const noexcept { return riserWritePtr >= riserBufferSize ? riserWritePtr - riserBufferSize : riserWritePtr; }
+    
+    // move the riser pointers to where the host position says the cycle should be, if they have drifted away from it
+    void alignToPosition(double ppqPosition, double ppqPositionOfLastBarStart);
+    
+    // how far (0 - 1) into a riser of 'riserLength' quarter notes the host position is, with the riser starting on bar lines
+    static double getBarCyclePosition(double ppqPosition, double ppqPositionOfLastBarStart, double riserLength, double barLength);
+    
+    // the riser pointers are moved when they are more than this many samples off the host position
+    int maxAlignmentError = 0;
+    
+    // recompute the buffer sizes when delayTime, riserLength or tempo change and start a crossfade from the old read position
+    void updateBufferSizes(float newDelayTime, float newRiserLength);
+    
+    // clear the storage a buffer grows into and fade out the end of its new length so the wraparound doesn't click
+    static void resizeInPlace(FrameBuffer<SampleType>& buffer, int oldSize, int newSize);
+    
+    FrameBuffer<SampleType> delayBuffer; // the delay line
+    
+//    the extra read heads over delayBuffer when there's more than one voice
+    RiserVoices voices;
+    
+//    the riser ring holds two riser lengths: the input sample from processBlock() is written at riserWritePtr while
+//    delayBuffer reads the cycle before it one riser length further round the ring, so when one half is finished
+//    writing the other is finished reading and both pointers simply carry on into the other's half
+    FrameBuffer<SampleType> riserBuffer;
+    
+//    the riser ring with RiserStorage::int16 (riserBuffer is left empty then), and the frame being read converted back
+    CompactFrameBuffer compactRiserBuffer;
+    FrameBuffer<SampleType> compactPlayFrame;
+    RiserStorage riserStorage = RiserStorage::float32;
+    
+//    the saturation of what's fed back into delayBuffer and of the wet signal, and the frame of wet lanes in between
+    Saturation::Stage feedbackSaturation;
+    Saturation::Stage outputSaturation;
+    FrameBuffer<SampleType> saturationFrame;
+    
+    size_t memoryLimit = 0;
+    bool memoryLimited = false;
+    
+//    scratch frames the channels are interleaved into and out of
+    FrameBuffer<SampleType> inputFrames;
+    FrameBuffer<SampleType> outputFrames;
+    
+    int numChannels = 1;
+    int numLanes = 1;
+    
+//    scratch space for the read-head kernel, which only runs on the float mono path
+    ReadHeadKernel::GatherFunction gather = ReadHeadKernel::getGatherFunction();
+    std::array<double, ReadHeadKernel::maxRunLength + 1> runPositions;
+    std::array<float, ReadHeadKernel::maxRunLength> runInterpolated;
+    std::array<float, ReadHeadKernel::maxRunLength> runGains;
+    
+//    the sinc coefficients and the other read-only tables, one copy for every RiserLine in the process
+    juce::SharedResourcePointer<SharedTables> sharedTables;
+    const Interpolation::SincTable& sincTable = sharedTables->getSincTable();
+    NoteLengths noteLengths;
+    juce::AudioPlayHead::TimeSignature timeSignature;
+    float riserPhase = 0.0f;
+    
+//    silence detection: the loudest wet sample since the last updateSleepState(), and how long everything has been silent
+    float wetPeak = 0.0f;
+    int numSilentFrames = 0;
+    bool asleep = false;
+    
+    double sampleRate = 44100.0; // not rounded, eco mode runs RiserLines at a half or a quarter of the host's rate
+    float feedback = 0.3f;
+    
+    int delayBufferSize = 0; // in samples
+    int riserBufferSize = 0; // in samples
+    int maxBufferSize = 0; // the preallocated length of every buffer in samples
+    
+    float currentDelayTime = 0.0f; // the delayTime index the buffer sizes were last computed for
+    float currentRiserLength = 0.0f; // the riserLength index the buffer sizes were last computed for
+    
+//    after a resize the old delay play pointer keeps reading for 'crossfadeLength' samples while the new one fades in
+    int crossfadeLength = 0;
+    int crossfadeRemaining = 0;
+    double crossfadePlayPtr = 0;
+    int crossfadeDelayBufferSize = 0;
+    
+//    the step delayBuffer uses to read out next delay sample and the step increases from 1 to accelerateCap 
+//    as delayBuffer reads out delay samples. (a double since the increments per sample are below the precision of a float near 1)
+    double accelerateBase = 1.0;
+    
+//    counts the riser cycles finished, including the ones skipped over while asleep
+    juce::uint32 numRiserSwitches = 0;
+    juce::uint32 numBufferResizes = 0;
+    juce::uint32 numAlignmentResets = 0;
+    
+//     the largest step delayBuffer uses to read out next delay sample
+//    ( '2' means reading out at twice the speed of the original signal which is also one octave higher)
+    float accelerateCap = 2.0f;
+    
+//    the fade-in and fade-out of a filled riser cycle are applied as it's read rather than to the whole cycle at the switch,
+//    and instead of being cleared it's simply overwritten frame by frame. Frames the write pointer jumped over
+//    (when the riser pointers are moved) hold older audio, so they're kept as a range read back as silence
+    juce::Range<int> riserWriteSkipped;
+    juce::Range<int> riserReadSkipped;
+
+    double dlyWritePtr = 0; // the pointer where input signal(from the riserBuffer) is written into delayBuffer
+    double dlyPlayPtr = 0; // the pointer where the output reads from delayBuffer
+    int riserWritePtr = 0; // the pointer where input signal(from the processBlock()) is written into riserBuffer (0 - 2 * riserBufferSize),
+                           // delayBuffer reads riserBufferSize frames further round the ring
+    double tempo = 120; // the BPM from the host (default value 120)
+};
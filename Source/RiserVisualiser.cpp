@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    RiserVisualiser.cpp
+    Created: 29 Mar 2024 4:35:17pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RiserVisualiser.h"
+
+RiserVisualiser::RiserVisualiser(Telemetry::Fifo& fifo)
+    : telemetry(fifo)
+{
+//    everything is drawn over a filled background, so nothing behind it is repainted with it
+    setOpaque(true);
+
+//    whatever was left in the FIFO from an earlier editor is stale
+    while (telemetry.pop(popped.data(), (int) popped.size()) > 0) {}
+    
+    telemetry.setActive(true);
+    startTimerHz(refreshRate);
+}
+
+RiserVisualiser::~RiserVisualiser()
+{
+    stopTimer();
+    telemetry.setActive(false);
+}
+
+void RiserVisualiser::resized()
+{
+    columns.assign((size_t) juce::jmax(1, getWidth()), Column());
+    writeColumn = 0;
+}
+
+void RiserVisualiser::timerCallback()
+{
+    int numPopped = 0;
+    int n = 0;
+    
+    while ((n = telemetry.pop(popped.data(), (int) popped.size())) > 0)
+    {
+        for (int i = 0; i < n; ++i)
+            addFrame(popped[(size_t) i]);
+        
+        numPopped += n;
+    }
+
+//    nothing moves while the host isn't processing, so there's nothing to repaint either
+    if (numPopped > 0)
+        repaint();
+}
+
+void RiserVisualiser::addFrame(const Telemetry::Frame& frame)
+{
+    if (hasLatest && frame.riserSwitches != latest.riserSwitches)
+        pendingColumn.riserStart = true;
+    
+    latest = frame;
+    hasLatest = true;
+    
+    pendingColumn.min = juce::jmin(pendingColumn.min, frame.outputMin);
+    pendingColumn.max = juce::jmax(pendingColumn.max, frame.outputMax);
+    pendingSamples += frame.numSamples;
+    
+    if (pendingSamples < samplesPerColumn || columns.empty())
+        return;
+    
+    columns[(size_t) writeColumn] = pendingColumn;
+    writeColumn = (writeColumn + 1) % (int) columns.size();
+    pendingColumn = Column();
+    pendingSamples = 0;
+}
+
+void RiserVisualiser::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black.withAlpha(0.85f));
+    
+    auto bounds = getLocalBounds().toFloat().reduced(2.0f);
+    const auto progressBar = bounds.removeFromTop(6.0f);
+    bounds.removeFromTop(2.0f);
+    const auto speedMeter = bounds.removeFromRight(6.0f);
+    bounds.removeFromRight(2.0f);
+    const auto waveform = bounds;
+
+//    the riser progress, across the top
+    g.setColour(juce::Colours::white.withAlpha(0.2f));
+    g.fillRect(progressBar);
+    g.setColour(juce::Colours::orange);
+    g.fillRect(progressBar.withWidth(progressBar.getWidth() * juce::jlimit(0.0f, 1.0f, latest.riserProgress)));
+
+//    the pitch ratio from 1 at the bottom to 'maxPlaybackSpeed' at the top
+    const float speed = juce::jlimit(0.0f, 1.0f, (latest.playbackSpeed - 1.0f) / (maxPlaybackSpeed - 1.0f));
+    g.setColour(juce::Colours::white.withAlpha(0.2f));
+    g.fillRect(speedMeter);
+    g.setColour(juce::Colours::orange);
+    g.fillRect(speedMeter.withTop(speedMeter.getBottom() - speedMeter.getHeight() * speed));
+
+//    the waveform scrolls left, the oldest column is the one about to be overwritten
+    const int numColumns = (int) columns.size();
+    const float centre = waveform.getCentreY();
+    const float halfHeight = waveform.getHeight() * 0.5f;
+    const float columnWidth = waveform.getWidth() / (float) juce::jmax(1, numColumns);
+    
+    for (int i = 0; i < numColumns; ++i)
+    {
+        const auto& column = columns[(size_t) ((writeColumn + i) % numColumns)];
+        const float x = waveform.getX() + (float) i * columnWidth;
+        
+        if (column.riserStart)
+        {
+            g.setColour(juce::Colours::orange.withAlpha(0.6f));
+            g.drawVerticalLine((int) x, waveform.getY(), waveform.getBottom());
+        }
+        
+        const float top = centre - halfHeight * juce::jlimit(-1.0f, 1.0f, column.max);
+        const float bottom = centre - halfHeight * juce::jlimit(-1.0f, 1.0f, column.min);
+        
+        g.setColour(juce::Colours::white.withAlpha(0.8f));
+        g.fillRect(x, top, juce::jmax(1.0f, columnWidth), juce::jmax(1.0f, bottom - top));
+    }
+    
+    g.setColour(juce::Colours::white);
+    g.setFont(11.0f);
+    g.drawText("x" + juce::String(latest.playbackSpeed, 2), waveform.withHeight(12.0f), juce::Justification::topRight);
+}
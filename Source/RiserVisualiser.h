@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    RiserVisualiser.h
+    Created: 29 Mar 2024 4:35:02pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+// Draws the telemetry the processor reports: a bar for how far the riser cycle has got, a meter for the speed
+// the delay is read at (the pitch ratio) and a scrolling waveform of the output with a line where every riser cycle starts.
+// It activates the FIFO while it exists and reads it on the message thread 'refreshRate' times a second.
+class RiserVisualiser  : public juce::Component,
+                         private juce::Timer
+{
+public:
+    explicit RiserVisualiser(Telemetry::Fifo& fifo);
+    ~RiserVisualiser() override;
+    
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    
+    static constexpr int refreshRate = 30;
+    
+    // the pitch ratio the meter shows as full (the top of the accelerateCap range)
+    static constexpr float maxPlaybackSpeed = 4.0f;
+
+private:
+    void timerCallback() override;
+
+//    add a frame to the waveform history
+    void addFrame(const Telemetry::Frame& frame);
+    
+    Telemetry::Fifo& telemetry;
+
+//    frames popped from the FIFO at a time, sized once so the timer never allocates
+    std::array<Telemetry::Frame, 256> popped;
+
+//    the newest frame, and the output range of every column of the waveform, written round 'writeColumn'
+    Telemetry::Frame latest;
+    struct Column
+    {
+        float min = 0.0f;
+        float max = 0.0f;
+        bool riserStart = false;
+    };
+    
+    std::vector<Column> columns;
+    int writeColumn = 0;
+
+//    frames are merged into one column until it covers 'samplesPerColumn' samples
+    static constexpr int samplesPerColumn = 512;
+    Column pendingColumn;
+    int pendingSamples = 0;
+    bool hasLatest = false;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RiserVisualiser)
+};
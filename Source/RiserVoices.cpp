@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    RiserVoices.cpp
+    Created: 23 Mar 2024 3:18:16pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "RiserVoices.h"
+
+bool RiserVoices::configure(int newNumVoices, float newSpread, float newAccelerateCap, int newRiserSize)
+{
+    newNumVoices = juce::jlimit(1, maxVoices, newNumVoices);
+    newRiserSize = juce::jmax(1, newRiserSize);
+    
+    if (newNumVoices == numVoices && newSpread == spread && newAccelerateCap == accelerateCap && newRiserSize == riserSize)
+        return false;
+    
+    const bool needsReset = newNumVoices != numVoices || newRiserSize != riserSize;
+    
+    numVoices = newNumVoices;
+    numExtraVoices = numVoices - 1;
+    spread = newSpread;
+    accelerateCap = newAccelerateCap;
+    riserSize = newRiserSize;
+    mixGain = 1.0f / std::sqrt((float) numVoices);
+
+//    voice 'v' starts v / numVoices of a cycle after the main read, and the caps fan out evenly around the main one
+    for (int voice = 0; voice < numExtraVoices; ++voice)
+    {
+        const double offset = (voice + 1.0) / numVoices;
+        const double spreadPosition = (voice + 0.5) / numExtraVoices - 0.5;
+        
+        cycleOffsets[(size_t) voice] = (int) (offset * riserSize);
+        caps[(size_t) voice] = 1.0 + (accelerateCap - 1.0) * (1.0 + spread * spreadPosition);
+        increments[(size_t) voice] = (caps[(size_t) voice] - 1.0) / riserSize;
+    }
+
+//    the padding of the last SIMDRegister stands still
+    for (int voice = numExtraVoices; voice < poolSize; ++voice)
+    {
+        bases[(size_t) voice] = 0.0;
+        increments[(size_t) voice] = 0.0;
+    }
+    
+    return needsReset;
+}
+
+void RiserVoices::reset(int cyclePosition, double position, int delaySize)
+{
+    for (int voice = 0; voice < numExtraVoices; ++voice)
+    {
+        const int voiceCyclePosition = ((cyclePosition - cycleOffsets[(size_t) voice]) % riserSize + riserSize) % riserSize;
+        
+        bases[(size_t) voice] = 1.0 + voiceCyclePosition * increments[(size_t) voice];
+        
+        if (bases[(size_t) voice] >= caps[(size_t) voice])
+            bases[(size_t) voice] = 1.0;
+
+//        the voices pick up from the main read, drifting apart from there until their own cycles restart them
+        positions[(size_t) voice] = juce::jlimit(0.0, juce::jmax(0.0, delaySize - 2.0), position);
+    }
+}
+
+template <typename SampleType>
+void RiserVoices::getReadTaps(int* indices, SampleType* fractions) const noexcept
+{
+    for (int voice = 0; voice < numExtraVoices; ++voice)
+    {
+        const double position = positions[(size_t) voice];
+        indices[voice] = (int) position;
+        fractions[voice] = (SampleType) (position - indices[voice]);
+    }
+}
+
+template void RiserVoices::getReadTaps(int*, float*) const noexcept;
+template void RiserVoices::getReadTaps(int*, double*) const noexcept;
+
+void RiserVoices::advance(int cyclePosition, double restartPosition, int delaySize) noexcept
+{
+    constexpr int width = (int) SIMDDouble::SIMDNumElements;
+    
+    for (int voice = 0; voice < numExtraVoices; voice += width)
+    {
+        const auto base = SIMDDouble::fromRawArray(bases.data() + voice);
+        const auto position = SIMDDouble::fromRawArray(positions.data() + voice) + base;
+        
+        position.copyToRawArray(positions.data() + voice);
+        (base + SIMDDouble::fromRawArray(increments.data() + voice)).copyToRawArray(bases.data() + voice);
+    }
+
+//    the same wraparounds as the main read: past the end of the delayBuffer back to the start, and back to the
+//    original speed at the cap or at the start of the voice's own cycle
+    for (int voice = 0; voice < numExtraVoices; ++voice)
+    {
+        double& position = positions[(size_t) voice];
+        double& base = bases[(size_t) voice];
+        
+        if (cyclePosition == cycleOffsets[(size_t) voice])
+        {
+            position = restartPosition;
+            base = 1.0;
+        }
+        
+        while (position < 0)
+            position += delaySize - 1;
+        
+        if (position >= delaySize - 1)
+            position = 0;
+        
+        if (base >= caps[(size_t) voice])
+            base = 1.0;
+    }
+}
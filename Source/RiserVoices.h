@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    RiserVoices.h
+    Created: 23 Mar 2024 3:18:09pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The extra voices of a denser riser: read heads over RiserLine's delayBuffer that run the same accelerating read as its
+// own, each starting a fraction of a riser cycle later and climbing to its own accelerateCap spread around the main one.
+// They only add to the output, the delay feedback stays on the main read, so every voice costs a read per frame but no memory.
+//
+// The voices live in a fixed pool laid out structure-of-arrays, so nothing is allocated when the count changes and
+// the read positions of all of them move on together a SIMDRegister at a time.
+class RiserVoices
+{
+public:
+    using SIMDDouble = juce::dsp::SIMDRegister<double>;
+    
+    // including RiserLine's own read
+    static constexpr int maxVoices = 8;
+    
+    // set the number of voices (1 leaves RiserLine's read on its own), how far their accelerateCaps spread around
+    // 'accelerateCap' (0 - 1, at 1 from half to one and a half times as far above 1) and the riser length they're
+    // staggered over. Returns true when the voices have to be reset() to take the change
+    bool configure(int numVoices, float spread, float accelerateCap, int riserSize);
+    
+    // the voices on top of RiserLine's own read
+    int getNumExtraVoices() const noexcept { return numExtraVoices; }
+    
+    // restart every voice where it would be with the riser cycle 'cyclePosition' frames in and the main read at 'position'
+    void reset(int cyclePosition, double position, int delaySize);
+    
+    // the first of the two delayBuffer frames each voice reads now and how far to the second (a float or a double),
+    // for linear interpolation
+    template <typename SampleType>
+    void getReadTaps(int* indices, SampleType* fractions) const noexcept;
+    
+    // move every voice on by one frame, and restart the ones whose cycle starts at 'cyclePosition' from 'restartPosition'
+    void advance(int cyclePosition, double restartPosition, int delaySize) noexcept;
+    
+    // the summed reads of all the voices are scaled by this so more voices don't get louder
+    float getMixGain() const noexcept { return mixGain; }
+
+private:
+    static constexpr int poolSize = maxVoices;
+
+//    one element per extra voice, padded to whole SIMDRegisters
+    alignas(32) std::array<double, poolSize> positions {};
+    alignas(32) std::array<double, poolSize> bases {};
+    alignas(32) std::array<double, poolSize> increments {};
+    std::array<double, poolSize> caps {};
+    std::array<int, poolSize> cycleOffsets {};
+    
+    int numExtraVoices = 0;
+    int numVoices = 1;
+    int riserSize = 0;
+    float spread = 0.0f;
+    float accelerateCap = 2.0f;
+    float mixGain = 1.0f;
+};
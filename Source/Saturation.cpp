@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    Saturation.cpp
+    Created: 24 Mar 2024 11:27:05am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "Saturation.h"
+
+namespace Saturation
+{
+
+void Stage::setCurve(Curve newCurve, bool shouldAntialias) noexcept
+{
+    if (newCurve == curve && shouldAntialias == antialiased)
+        return;
+
+//    the antiderivatives kept are for the old curve, so the antialiasing starts over from the next input
+    curve = newCurve;
+    antialiased = shouldAntialias;
+    hasPrevious = false;
+}
+
+template <typename SampleType>
+void Stage::processRun(const SampleType* input, SampleType* output, int numSamples) noexcept
+{
+    switch (curve)
+    {
+        case Curve::softClip:   processRun<Curve::softClip>(input, output, numSamples); break;
+        case Curve::tanh:       processRun<Curve::tanh>(input, output, numSamples); break;
+        case Curve::hardClip:
+        default:                processRun<Curve::hardClip>(input, output, numSamples); break;
+    }
+}
+
+template <Curve curveToUse, typename SampleType>
+void Stage::processRun(const SampleType* input, SampleType* output, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+    
+    if (! antialiased)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = Saturation::apply<curveToUse>(input[i]);
+        
+        return;
+    }
+    
+    if (! hasPrevious)
+    {
+        previousInputs[0] = input[0];
+        previousAntiderivatives[0] = getAntiderivative<curveToUse>(input[0]);
+        hasPrevious = true;
+    }
+
+//    the antiderivative of each input is worked out once and carried over as the next one's previous
+    SampleType previous = (SampleType) previousInputs[0];
+    double previousAntiderivative = previousAntiderivatives[0];
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const SampleType x = input[i];
+        const double antiderivative = getAntiderivative<curveToUse>(x);
+        
+        output[i] = applyAntialiased<curveToUse>(x, previous, antiderivative, previousAntiderivative);
+        previous = x;
+        previousAntiderivative = antiderivative;
+    }
+    
+    previousInputs[0] = previous;
+    previousAntiderivatives[0] = previousAntiderivative;
+}
+
+template void Stage::processRun(const float*, float*, int) noexcept;
+template void Stage::processRun(const double*, double*, int) noexcept;
+
+}
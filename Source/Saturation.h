@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    Saturation.h
+    Created: 24 Mar 2024 11:26:52am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The curves the RiserLine's feedback loop and output go through to keep their levels bounded. Every curve is symmetric
+// with a slope of 1 around 0 and is worked out with clamps instead of branches on the sample, so a frame of lanes or a run
+// of samples is one straight loop the compiler can vectorise.
+//
+// With antialiasing a stage uses first-order antiderivative antialiasing (ADAA): the output is the mean of the curve
+// between the previous input and this one, (F(x[n]) - F(x[n - 1])) / (x[n] - x[n - 1]) with F the antiderivative of the
+// curve, which takes out most of the aliasing the corners of the curve fold back, for half a sample of delay.
+namespace Saturation
+{
+    enum class Curve
+    {
+        hardClip = 0,   // clamped at +-0.99
+        softClip,       // cubic, levels off at +-1 from +-1.5
+        tanh            // rational approximation of tanh, levels off at +-1 from +-3
+    };
+    
+    constexpr float hardClipLevel = 0.99f;
+    
+    // the operations the curves need, for a float or a double and for the lanes of a SIMDRegister of either
+    inline float clamp(float x, double limit) noexcept { return juce::jmin(juce::jmax(x, (float) -limit), (float) limit); }
+    inline double clamp(double x, double limit) noexcept { return juce::jmin(juce::jmax(x, -limit), limit); }
+    inline float divide(float x, float y) noexcept { return x / y; }
+    inline double divide(double x, double y) noexcept { return x / y; }
+    
+    template <typename ElementType>
+    inline juce::dsp::SIMDRegister<ElementType> clamp(juce::dsp::SIMDRegister<ElementType> x, double limit) noexcept
+    {
+        using Register = juce::dsp::SIMDRegister<ElementType>;
+        return Register::min(Register::max(x, Register::expand((ElementType) -limit)), Register::expand((ElementType) limit));
+    }
+
+//    SIMDRegister has no division, the lanes are divided one by one
+    template <typename ElementType>
+    inline juce::dsp::SIMDRegister<ElementType> divide(juce::dsp::SIMDRegister<ElementType> x, juce::dsp::SIMDRegister<ElementType> y) noexcept
+    {
+        for (size_t lane = 0; lane < juce::dsp::SIMDRegister<ElementType>::SIMDNumElements; ++lane)
+            x.set(lane, x.get(lane) / y.get(lane));
+        
+        return x;
+    }
+    
+    template <Curve curve, typename SampleType>
+    inline SampleType apply(SampleType x) noexcept
+    {
+        if constexpr (curve == Curve::hardClip)
+        {
+            return clamp(x, hardClipLevel);
+        }
+        else if constexpr (curve == Curve::softClip)
+        {
+            const SampleType c = clamp(x, 1.5f);
+            return c - c * c * c * (1.0f / 6.75f);
+        }
+        else
+        {
+            const SampleType c = clamp(x, 3.0f);
+            const SampleType c2 = c * c;
+            return divide(c * (c2 + 27.0f), c2 * 9.0f + 27.0f);
+        }
+    }
+    
+    // the antiderivative of apply() that is 0 at 0, in double since ADAA divides the difference of two of them
+    template <Curve curve>
+    inline double getAntiderivative(double x) noexcept
+    {
+        if constexpr (curve == Curve::hardClip)
+        {
+            const double c = juce::jlimit((double) -hardClipLevel, (double) hardClipLevel, x);
+            return c * x - 0.5 * c * c;
+        }
+        else if constexpr (curve == Curve::softClip)
+        {
+            const double c = juce::jlimit(-1.5, 1.5, x);
+            const double c2 = c * c;
+            return 0.5 * c2 - c2 * c2 * (1.0 / 27.0) + (std::abs(x) - std::abs(c));
+        }
+        else
+        {
+            const double c = juce::jlimit(-3.0, 3.0, x);
+            const double c2 = c * c;
+            return c2 * (1.0 / 18.0) + (4.0 / 3.0) * std::log1p(c2 * (1.0 / 3.0)) + (std::abs(x) - std::abs(c));
+        }
+    }
+    
+    // inputs closer together than this would divide the rounding error of the antiderivatives up,
+    // the curve at their midpoint is as good as the mean then
+    constexpr double antialiasingTolerance = 1.0e-5;
+    
+    // the mean of the curve from 'previous' to 'x', given the antiderivative at both
+    template <Curve curve, typename SampleType>
+    inline SampleType applyAntialiased(SampleType x, SampleType previous, double antiderivative, double previousAntiderivative) noexcept
+    {
+        const double difference = (double) x - (double) previous;
+        const bool close = std::abs(difference) < antialiasingTolerance;
+        const double mean = (antiderivative - previousAntiderivative) / (close ? 1.0 : difference);
+        return close ? apply<curve>((SampleType) 0.5 * (x + previous)) : (SampleType) mean;
+    }
+    
+    // One saturation stage, keeping the previous input of every lane for the antialiasing. Nothing here allocates,
+    // so the curve can be changed on the audio thread.
+    class Stage
+    {
+    public:
+        static constexpr int maxLanes = 8;
+        
+        void setCurve(Curve newCurve, bool shouldAntialias) noexcept;
+        
+        Curve getCurve() const noexcept { return curve; }
+        bool isAntialiased() const noexcept { return antialiased; }
+        
+        // forget the previous inputs, the next ones are taken as they come
+        void reset() noexcept { hasPrevious = false; }
+        
+        // the curve on its own, without the antialiasing (a float, a double or a SIMDRegister of either)
+        template <typename SampleType>
+        SampleType apply(SampleType x) const noexcept
+        {
+            switch (curve)
+            {
+                case Curve::softClip:   return Saturation::apply<Curve::softClip>(x);
+                case Curve::tanh:       return Saturation::apply<Curve::tanh>(x);
+                case Curve::hardClip:
+                default:                return Saturation::apply<Curve::hardClip>(x);
+            }
+        }
+        
+        // saturate the samples of 'numLanes' lanes from 'firstLane' on in place, each lane following on from its own
+        // previous sample (pass the same lanes every time). Inline, since RiserLine saturates every frame
+        template <typename SampleType>
+        void processLanes(SampleType* samples, int firstLane, int numLanes) noexcept
+        {
+            jassert(firstLane + numLanes <= maxLanes);
+            
+            switch (curve)
+            {
+                case Curve::softClip:   processLanes<Curve::softClip>(samples, firstLane, numLanes); break;
+                case Curve::tanh:       processLanes<Curve::tanh>(samples, firstLane, numLanes); break;
+                case Curve::hardClip:
+                default:                processLanes<Curve::hardClip>(samples, firstLane, numLanes); break;
+            }
+        }
+        
+        template <typename SampleType>
+        SampleType processSample(SampleType x, int lane) noexcept
+        {
+            processLanes(&x, lane, 1);
+            return x;
+        }
+        
+        // saturate a run of samples of the first lane ('input' and 'output' may point to the same memory)
+        template <typename SampleType>
+        void processRun(const SampleType* input, SampleType* output, int numSamples) noexcept;
+    
+    private:
+        template <Curve curveToUse, typename SampleType>
+        void processLanes(SampleType* samples, int firstLane, int numLanes) noexcept
+        {
+            if (! antialiased)
+            {
+                for (int lane = 0; lane < numLanes; ++lane)
+                    samples[lane] = Saturation::apply<curveToUse>(samples[lane]);
+                
+                return;
+            }
+            
+            double* previous = previousInputs.data() + firstLane;
+            double* previousAntiderivative = previousAntiderivatives.data() + firstLane;
+            
+            if (! hasPrevious)
+            {
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    previous[lane] = samples[lane];
+                    previousAntiderivative[lane] = getAntiderivative<curveToUse>(samples[lane]);
+                }
+                
+                hasPrevious = true;
+            }
+
+//            the lanes don't depend on each other, so the loop vectorises
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const SampleType x = samples[lane];
+                const double antiderivative = getAntiderivative<curveToUse>(x);
+                
+                samples[lane] = applyAntialiased<curveToUse>(x, (SampleType) previous[lane], antiderivative, previousAntiderivative[lane]);
+                previous[lane] = x;
+                previousAntiderivative[lane] = antiderivative;
+            }
+        }
+        
+        template <Curve curveToUse, typename SampleType>
+        void processRun(const SampleType* input, SampleType* output, int numSamples) noexcept;
+        
+        Curve curve = Curve::hardClip;
+        bool antialiased = false;
+
+//    the previous inputs and their antiderivatives for the current curve, only kept while antialiasing
+//    (in double, which holds a float input exactly as well)
+        std::array<double, maxLanes> previousInputs {};
+        std::array<double, maxLanes> previousAntiderivatives {};
+        bool hasPrevious = false;
+    };
+}
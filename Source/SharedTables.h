@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+    SharedTables.h
+    Created: 19 Mar 2024 10:52:36am
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Interpolation.h"
+
+// The read-only tables every RiserLine reads from. Hold them through a juce::SharedResourcePointer<SharedTables>:
+// the first instance in the process builds them, the rest share the same copy, and the last one to go frees it.
+// Nothing here changes after construction, so the audio threads of every instance can read it without locking.
+class SharedTables
+{
+public:
+    SharedTables() = default;
+    
+    const Interpolation::SincTable& getSincTable() const noexcept { return sincTable; }
+    
+    // the bytes held by the tables (counted once for the whole process)
+    size_t getSizeInBytes() const noexcept { return sincTable.getSizeInBytes(); }
+
+private:
+    const Interpolation::SincTable sincTable;
+    
+    JUCE_DECLARE_NON_COPYABLE (SharedTables)
+};
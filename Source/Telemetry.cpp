@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    Telemetry.cpp
+    Created: 29 Mar 2024 3:48:29pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "Telemetry.h"
+
+namespace Telemetry
+{
+
+bool Fifo::push(const Frame& frame) noexcept
+{
+    const auto scope = fifo.write(1);
+    
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    frames[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = frame;
+    return true;
+}
+
+int Fifo::pop(Frame* dest, int maxFrames) noexcept
+{
+    const auto scope = fifo.read(maxFrames);
+    
+    std::copy_n(frames.begin() + scope.startIndex1, scope.blockSize1, dest);
+    std::copy_n(frames.begin() + scope.startIndex2, scope.blockSize2, dest + scope.blockSize1);
+    
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+    Created: 29 Mar 2024 3:48:16pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// What the audio thread reports to the editor about the riser: one Frame for every parameter interval processed,
+// passed through a wait-free single producer / single consumer FIFO. The audio thread never waits and never allocates,
+// when the editor falls behind and the FIFO is full the newest frames are dropped and counted.
+namespace Telemetry
+{
+    struct Frame
+    {
+        float riserProgress = 0.0f;         // how far into the riser cycle the end of the frame is (0 - 1)
+        float playbackSpeed = 1.0f;         // the speed the delay is read at (accelerateBase), the pitch ratio of the riser
+        juce::uint32 riserSwitches = 0;     // the number of riser cycles finished so far, a change means a new cycle started
+        float outputMin = 0.0f;             // the range of the output samples of the frame over every channel
+        float outputMax = 0.0f;
+        int numSamples = 0;
+    };
+    
+    class Fifo
+    {
+    public:
+        static constexpr int capacity = 1024;
+        
+        // the audio thread only pushes while this is set, so frames don't pile up with no editor to read them
+        void setActive(bool shouldBeActive) noexcept { active = shouldBeActive; }
+        bool isActive() const noexcept { return active.load(std::memory_order_relaxed); }
+        
+        // producer side (the audio thread): false when the FIFO is full and the frame was dropped
+        bool push(const Frame& frame) noexcept;
+        
+        // consumer side: take up to 'maxFrames' of the oldest frames, returns the number taken
+        int pop(Frame* dest, int maxFrames) noexcept;
+        
+        // the frames dropped so far because the FIFO was full
+        juce::uint32 getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+    
+    private:
+        juce::AbstractFifo fifo { capacity };
+        std::array<Frame, capacity> frames;
+        
+        std::atomic<bool> active { false };
+        std::atomic<juce::uint32> numDropped { 0 };
+    };
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    TempoEngine.cpp
+    Created: 16 Mar 2024 3:27:58pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "TempoEngine.h"
+
+bool NoteLengths::update(double tempo, juce::AudioPlayHead::TimeSignature timeSignature, double sampleRate)
+{
+    if (tempo == currentTempo && timeSignature.numerator == currentNumerator
+        && timeSignature.denominator == currentDenominator && sampleRate == currentSampleRate)
+        return false;
+    
+    currentTempo = tempo;
+    currentNumerator = timeSignature.numerator;
+    currentDenominator = timeSignature.denominator;
+    currentSampleRate = sampleRate;
+    
+    const double barLength = timeSignature.numerator * 4.0 / timeSignature.denominator;
+    
+    lengthsInQuarterNotes = { 0.0,
+                              0.125,          // 1/32 note
+                              0.25,           // 1/16 note
+                              0.5,            // 1/8 note
+                              1.0,            // 1/4 note
+                              2.0,            // 1/2 note
+                              barLength,      // 1 bar
+                              barLength * 2 }; // 2 bars
+    
+    const double samplesPerQuarterNote = 60.0 / tempo * sampleRate;
+    
+    for (size_t index = 0; index < lengthsInSamples.size(); ++index)
+        lengthsInSamples[index] = (int) (lengthsInQuarterNotes[index] * samplesPerQuarterNote);
+    
+    return true;
+}
+
+void TempoEngine::update(juce::AudioPlayHead* playHead)
+{
+    positionKnown = false;
+    
+    if (playHead == nullptr)
+        return;
+    
+    const auto position = playHead->getPosition();
+    
+    if (! position)
+        return;
+    
+    if (auto bpm = position->getBpm())
+        if (*bpm > 0.0)
+            tempo = *bpm;
+    
+    if (auto signature = position->getTimeSignature())
+        if (signature->numerator > 0 && signature->denominator > 0)
+            timeSignature = *signature;
+    
+    auto ppq = position->getPpqPosition();
+    
+    if (! position->getIsPlaying() || ! ppq)
+        return;
+    
+    positionKnown = true;
+    ppqPosition = *ppq;
+
+//    hosts that leave out the bar position get one counted from the start of the song in the current time signature
+    const double barLength = timeSignature.numerator * 4.0 / timeSignature.denominator;
+    
+    if (auto lastBarStart = position->getPpqPositionOfLastBarStart())
+        ppqPositionOfLastBarStart = *lastBarStart;
+    else
+        ppqPositionOfLastBarStart = std::floor(ppqPosition / barLength) * barLength;
+}
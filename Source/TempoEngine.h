@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    TempoEngine.h
+    Created: 16 Mar 2024 3:27:50pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// The length in samples of every note division index, worked out once and recomputed only when the tempo,
+// time signature or sample rate actually change.
+// (indices 1 - 7 correspond to 1/32, 1/16, 1/8, 1/4, 1/2 notes, 1 bar and 2 bars)
+class NoteLengths
+{
+public:
+    static constexpr int numIndices = 7;
+    
+    // recompute the lengths if anything changed, returns true if it did
+    bool update(double tempo, juce::AudioPlayHead::TimeSignature timeSignature, double sampleRate);
+    
+    // indices outside 1 - 7 fall back to a 1/4 note
+    int getLengthInSamples(float index) const noexcept { return lengthsInSamples[(size_t) getTableIndex(index)]; }
+    double getLengthInQuarterNotes(float index) const noexcept { return lengthsInQuarterNotes[(size_t) getTableIndex(index)]; }
+    
+    double getBarLengthInQuarterNotes() const noexcept { return lengthsInQuarterNotes[6]; }
+
+private:
+    static int getTableIndex(float index) noexcept { return (int) index >= 1 && (int) index <= numIndices ? (int) index : 4; }
+    
+    std::array<int, numIndices + 1> lengthsInSamples {};
+    std::array<double, numIndices + 1> lengthsInQuarterNotes {};
+    
+    double currentTempo = 0.0;
+    int currentNumerator = 0;
+    int currentDenominator = 0;
+    double currentSampleRate = 0.0;
+};
+
+// Reads the host's tempo, time signature and transport position at the start of every block without assuming any
+// of it is there: without a play head, or when the host leaves a field out, the last known tempo and time signature
+// are kept and the position is reported as unknown.
+class TempoEngine
+{
+public:
+    void prepare(double newSampleRate) { sampleRate = newSampleRate; }
+    
+    void update(juce::AudioPlayHead* playHead);
+    
+    double getTempo() const noexcept { return tempo; }
+    juce::AudioPlayHead::TimeSignature getTimeSignature() const noexcept { return timeSignature; }
+    
+    // true while the transport is playing and the host reports where it is in PPQ
+    bool hasPosition() const noexcept { return positionKnown; }
+    
+    // the PPQ position 'sampleOffset' samples into the block, and of the bar line before it
+    double getPpqPosition(int sampleOffset = 0) const noexcept { return ppqPosition + sampleOffset * tempo / (60.0 * sampleRate); }
+    double getPpqPositionOfLastBarStart() const noexcept { return ppqPositionOfLastBarStart; }
+
+private:
+    double sampleRate = 44100.0;
+    double tempo = 120.0;
+    juce::AudioPlayHead::TimeSignature timeSignature;
+    
+    bool positionKnown = false;
+    double ppqPosition = 0.0;
+    double ppqPositionOfLastBarStart = 0.0;
+};
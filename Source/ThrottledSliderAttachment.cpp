@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ThrottledSliderAttachment.cpp
+    Created: 26 Mar 2024 8:12:51pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#include "ThrottledSliderAttachment.h"
+
+ThrottledSliderAttachment::ThrottledSliderAttachment(juce::RangedAudioParameter& parameter, juce::Slider& newSlider,
+                                                     int maxUpdatesPerSecond, juce::UndoManager* undoManager)
+    : slider(newSlider),
+      attachment(parameter, [this] (float newValue) { parameterChanged(newValue); }, undoManager),
+      minUpdateInterval((juce::uint32) (1000 / juce::jmax(1, maxUpdatesPerSecond)))
+{
+//    the slider shows the parameter's own text and range, the same as SliderAttachment
+    slider.valueFromTextFunction = [&parameter] (const juce::String& text)
+    {
+        return (double) parameter.convertFrom0to1(parameter.getValueForText(text));
+    };
+    
+    slider.textFromValueFunction = [&parameter] (double value)
+    {
+        return parameter.getText(parameter.convertTo0to1((float) value), 0);
+    };
+    
+    slider.setDoubleClickReturnValue(true, parameter.convertFrom0to1(parameter.getDefaultValue()));
+    
+    const auto& range = parameter.getNormalisableRange();
+    slider.setNormalisableRange({ range.start, range.end, range.interval, range.skew, range.symmetricSkew });
+    
+    attachment.sendInitialUpdate();
+    slider.updateText();
+    slider.addListener(this);
+}
+
+ThrottledSliderAttachment::~ThrottledSliderAttachment()
+{
+    slider.removeListener(this);
+}
+
+void ThrottledSliderAttachment::parameterChanged(float newValue)
+{
+    const auto now = juce::Time::getMillisecondCounter();
+
+//    while the user drags the slider it already shows the value, and a quiet spell shows the change at once
+    if (slider.isMouseButtonDown() || now - lastUpdateTime >= minUpdateInterval)
+    {
+        stopTimer();
+        showValue(newValue);
+        return;
+    }
+
+//    otherwise the latest value waits for the end of the interval, however many arrive in the meantime
+    pendingValue = newValue;
+    
+    if (! isTimerRunning())
+        startTimer((int) (minUpdateInterval - (now - lastUpdateTime)));
+}
+
+void ThrottledSliderAttachment::showValue(float newValue)
+{
+    lastUpdateTime = juce::Time::getMillisecondCounter();
+    
+    const juce::ScopedValueSetter<bool> svs(ignoreCallbacks, true);
+    slider.setValue(newValue, juce::sendNotificationSync);
+}
+
+void ThrottledSliderAttachment::timerCallback()
+{
+    stopTimer();
+    showValue(pendingValue);
+}
+
+void ThrottledSliderAttachment::sliderValueChanged(juce::Slider*)
+{
+    if (! ignoreCallbacks)
+        attachment.setValueAsPartOfGesture((float) slider.getValue());
+}
+
+void ThrottledSliderAttachment::sliderDragStarted(juce::Slider*)
+{
+    attachment.beginGesture();
+}
+
+void ThrottledSliderAttachment::sliderDragEnded(juce::Slider*)
+{
+    attachment.endGesture();
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ThrottledSliderAttachment.h
+    Created: 26 Mar 2024 8:12:40pm
+    Author:  Zi Meng
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Connects a Slider to a parameter like AudioProcessorValueTreeState::SliderAttachment, except that changes coming from
+// the host (automation) reach the slider at most 'maxUpdatesPerSecond' times a second. The first change after a quiet spell
+// shows straight away and the latest one is always shown in the end, so automation doesn't repaint the slider on every
+// block. Changes made with the slider go straight to the parameter as before.
+class ThrottledSliderAttachment  : private juce::Slider::Listener,
+                                   private juce::Timer
+{
+public:
+    ThrottledSliderAttachment(juce::RangedAudioParameter& parameter, juce::Slider& slider,
+                              int maxUpdatesPerSecond = 30, juce::UndoManager* undoManager = nullptr);
+    
+    ~ThrottledSliderAttachment() override;
+
+private:
+//    the parameter moved (called on the message thread)
+    void parameterChanged(float newValue);
+    
+    void showValue(float newValue);
+    
+    void sliderValueChanged(juce::Slider*) override;
+    void sliderDragStarted(juce::Slider*) override;
+    void sliderDragEnded(juce::Slider*) override;
+    
+    void timerCallback() override;
+    
+    juce::Slider& slider;
+    juce::ParameterAttachment attachment;
+    
+    const juce::uint32 minUpdateInterval; // in ms
+    juce::uint32 lastUpdateTime = 0;
+    float pendingValue = 0.0f;
+
+//    set while the slider is being moved to the parameter's value, so it isn't sent back
+    bool ignoreCallbacks = false;
+    
+    JUCE_DECLARE_NON_COPYABLE (ThrottledSliderAttachment)
+};